@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+
+namespace SS
+{
+    // Counts calls to the global operator new. Only builds defining
+    // SS_COUNT_ALLOCATIONS (Debug) replace the global operators; elsewhere the
+    // count stays zero and kEnabled is false.
+    class AllocationCounter {
+    public:
+#ifdef SS_COUNT_ALLOCATIONS
+        static constexpr bool kEnabled = true;
+#else
+        static constexpr bool kEnabled = false;
+#endif
+
+        static uint64_t total();
+    };
+}
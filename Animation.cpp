@@ -0,0 +1,354 @@
+#include "Animation.h"
+#include "ModelManager.h"
+#include "MemoryTracker.h"
+#include <imgui.h>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SS_ANIMATION_SSE 1
+#endif
+
+namespace SS
+{
+    namespace
+    {
+#ifdef SS_ANIMATION_SSE
+        // Horizontal sum of a*b broadcast to all four lanes
+        inline __m128 dot4(__m128 a, __m128 b) {
+            __m128 m = _mm_mul_ps(a, b);
+            __m128 s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+            return _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+        }
+
+        inline __m128 nlerp(__m128 a, __m128 b, __m128 t) {
+            // Flip b onto a's hemisphere so the blend takes the shortest arc
+            __m128 negative = _mm_cmplt_ps(dot4(a, b), _mm_setzero_ps());
+            b = _mm_xor_ps(b, _mm_and_ps(negative, _mm_set1_ps(-0.0f)));
+            __m128 r = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+            return _mm_div_ps(r, _mm_sqrt_ps(dot4(r, r)));
+        }
+
+        inline __m128 lerp(__m128 a, __m128 b, __m128 t) {
+            return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+        }
+#endif
+
+        inline glm::vec4 nlerpQuat(const glm::vec4& a, const glm::vec4& b, float t) {
+#ifdef SS_ANIMATION_SSE
+            glm::vec4 out;
+            _mm_storeu_ps(&out.x, nlerp(_mm_loadu_ps(&a.x), _mm_loadu_ps(&b.x), _mm_set1_ps(t)));
+            return out;
+#else
+            glm::vec4 target = glm::dot(a, b) < 0.0f ? -b : b;
+            return glm::normalize(a + (target - a) * t);
+#endif
+        }
+
+        // A cursor walks at most this many keys before it searches instead, so
+        // a wrap or a seek costs a binary search rather than a linear scan
+        constexpr uint32_t kMaxKeySteps = 4;
+
+        uint32_t searchKey(const AnimationChannel& channel, float time) {
+            auto it = std::upper_bound(channel.times.begin(), channel.times.end(), time);
+            return it == channel.times.begin() ? 0u : static_cast<uint32_t>(it - channel.times.begin() - 1);
+        }
+
+        // Last key at or before `time` (0 before the first), from the key used
+        // last: forward for normal playback, backward for negative speeds.
+        uint32_t seekKey(const AnimationChannel& channel, uint32_t key, float time) {
+            const uint32_t last = static_cast<uint32_t>(channel.times.size()) - 1;
+            if (key > last) return searchKey(channel, time);
+            uint32_t steps = 0;
+            while (key < last && channel.times[key + 1] <= time) {
+                if (++steps > kMaxKeySteps) return searchKey(channel, time);
+                ++key;
+            }
+            while (key > 0 && channel.times[key] > time) {
+                if (++steps > kMaxKeySteps) return searchKey(channel, time);
+                --key;
+            }
+            return key;
+        }
+
+        glm::mat4 composeTRS(const glm::vec4& t, const glm::vec4& r, const glm::vec4& s) {
+            glm::mat4 m = glm::mat4_cast(glm::quat(r.w, r.x, r.y, r.z));
+            m[0] *= s.x;
+            m[1] *= s.y;
+            m[2] *= s.z;
+            m[3] = glm::vec4(t.x, t.y, t.z, 1.0f);
+            return m;
+        }
+
+        void evaluateHierarchy(const Skeleton& skeleton, const glm::vec4* translations, const glm::vec4* rotations,
+            const glm::vec4* scales, glm::mat4* globals, glm::mat4* palette) {
+            for (int node : skeleton.evaluationOrder) {
+                glm::mat4 local = composeTRS(translations[node], rotations[node], scales[node]);
+                int parent = skeleton.parents[node];
+                globals[node] = parent >= 0 ? globals[parent] * local : local;
+            }
+            for (size_t j = 0; j < skeleton.jointNodes.size(); ++j) {
+                palette[j] = globals[skeleton.jointNodes[j]] * skeleton.inverseBindMatrices[j];
+            }
+        }
+    }
+
+    void ResetPose(const Skeleton& skeleton, Pose& pose) {
+        pose.translations = skeleton.restTranslations;
+        pose.rotations = skeleton.restRotations;
+        pose.scales = skeleton.restScales;
+    }
+
+    void ResetPose(const Skeleton& skeleton, PoseView pose) {
+        size_t count = std::min(pose.count, skeleton.nodeCount());
+        std::copy_n(skeleton.restTranslations.begin(), count, pose.translations);
+        std::copy_n(skeleton.restRotations.begin(), count, pose.rotations);
+        std::copy_n(skeleton.restScales.begin(), count, pose.scales);
+    }
+
+    void SampleClip(const AnimationClip& clip, float time, ClipCursor& cursor, Pose& pose) {
+        if (cursor.keys.size() != clip.channels.size()) cursor.keys.assign(clip.channels.size(), 0);
+        SampleClip(clip, time, cursor.keys.data(), MakePoseView(pose));
+    }
+
+    void SampleClip(const AnimationClip& clip, float time, uint32_t* keys, PoseView pose) {
+        for (size_t c = 0; c < clip.channels.size(); ++c) {
+            const AnimationChannel& channel = clip.channels[c];
+            if (channel.node < 0 || channel.node >= static_cast<int>(pose.count) || channel.times.empty()) continue;
+
+            uint32_t& key = keys[c];
+            const uint32_t last = static_cast<uint32_t>(channel.times.size()) - 1;
+            key = seekKey(channel, key, time);
+
+            glm::vec4 value;
+            if (key >= last || time <= channel.times[0]) {
+                value = channel.values[time <= channel.times[0] ? 0 : last];
+            }
+            else if (channel.step) {
+                value = channel.values[key];
+            }
+            else {
+                float t0 = channel.times[key], t1 = channel.times[key + 1];
+                float t = t1 > t0 ? (time - t0) / (t1 - t0) : 0.0f;
+                value = channel.path == AnimationPath::Rotation
+                    ? nlerpQuat(channel.values[key], channel.values[key + 1], t)
+                    : glm::mix(channel.values[key], channel.values[key + 1], t);
+            }
+
+            switch (channel.path) {
+            case AnimationPath::Translation: pose.translations[channel.node] = value; break;
+            case AnimationPath::Rotation: pose.rotations[channel.node] = value; break;
+            case AnimationPath::Scale: pose.scales[channel.node] = value; break;
+            }
+        }
+    }
+
+    void BlendPoses(const Pose& a, const Pose& b, float weight, Pose& out) {
+        size_t count = std::min(a.rotations.size(), b.rotations.size());
+        out.translations.resize(count);
+        out.rotations.resize(count);
+        out.scales.resize(count);
+#ifdef SS_ANIMATION_SSE
+        __m128 w = _mm_set1_ps(weight);
+        for (size_t i = 0; i < count; ++i) {
+            _mm_storeu_ps(&out.translations[i].x, lerp(_mm_loadu_ps(&a.translations[i].x), _mm_loadu_ps(&b.translations[i].x), w));
+            _mm_storeu_ps(&out.rotations[i].x, nlerp(_mm_loadu_ps(&a.rotations[i].x), _mm_loadu_ps(&b.rotations[i].x), w));
+            _mm_storeu_ps(&out.scales[i].x, lerp(_mm_loadu_ps(&a.scales[i].x), _mm_loadu_ps(&b.scales[i].x), w));
+        }
+#else
+        for (size_t i = 0; i < count; ++i) {
+            out.translations[i] = glm::mix(a.translations[i], b.translations[i], weight);
+            out.rotations[i] = nlerpQuat(a.rotations[i], b.rotations[i], weight);
+            out.scales[i] = glm::mix(a.scales[i], b.scales[i], weight);
+        }
+#endif
+    }
+
+    void ComputeSkinningMatrices(const Skeleton& skeleton, const Pose& pose,
+        std::vector<glm::mat4>& globals, std::vector<glm::mat4>& palette) {
+        globals.resize(skeleton.nodeCount());
+        palette.resize(skeleton.jointNodes.size());
+        evaluateHierarchy(skeleton, pose.translations.data(), pose.rotations.data(), pose.scales.data(),
+            globals.data(), palette.data());
+    }
+
+    void ComputeSkinningMatrices(const Skeleton& skeleton, PoseView pose, glm::mat4* globals, glm::mat4* palette) {
+        evaluateHierarchy(skeleton, pose.translations, pose.rotations, pose.scales, globals, palette);
+    }
+
+    void SkinVertices(const Vertex* in, Vertex* out, size_t count, const glm::mat4* palette, size_t paletteSize) {
+        for (size_t v = 0; v < count; ++v) {
+            const Vertex& src = in[v];
+            Vertex& dst = out[v];
+            dst.TexCoord = src.TexCoord;
+            dst.Joints = src.Joints;
+            dst.Weights = src.Weights;
+#ifdef SS_ANIMATION_SSE
+            __m128 c0 = _mm_setzero_ps(), c1 = _mm_setzero_ps(), c2 = _mm_setzero_ps(), c3 = _mm_setzero_ps();
+            for (int i = 0; i < 4; ++i) {
+                float weight = src.Weights[i];
+                if (weight == 0.0f || src.Joints[i] >= paletteSize) continue;
+                const float* m = glm::value_ptr(palette[src.Joints[i]]);
+                __m128 w = _mm_set1_ps(weight);
+                c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(m), w));
+                c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(m + 4), w));
+                c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(m + 8), w));
+                c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(m + 12), w));
+            }
+            __m128 p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(src.Position.x)), _mm_mul_ps(c1, _mm_set1_ps(src.Position.y))),
+                _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(src.Position.z)), c3));
+            __m128 n = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(src.Normal.x)), _mm_mul_ps(c1, _mm_set1_ps(src.Normal.y))),
+                _mm_mul_ps(c2, _mm_set1_ps(src.Normal.z)));
+            alignas(16) float pos[4], nrm[4];
+            _mm_store_ps(pos, p);
+            _mm_store_ps(nrm, n);
+            dst.Position = glm::vec3(pos[0], pos[1], pos[2]);
+            glm::vec3 normal(nrm[0], nrm[1], nrm[2]);
+#else
+            glm::mat4 m(0.0f);
+            for (int i = 0; i < 4; ++i) {
+                if (src.Weights[i] == 0.0f || src.Joints[i] >= paletteSize) continue;
+                m += palette[src.Joints[i]] * src.Weights[i];
+            }
+            dst.Position = glm::vec3(m * glm::vec4(src.Position, 1.0f));
+            glm::vec3 normal = glm::vec3(m * glm::vec4(src.Normal, 0.0f));
+#endif
+            float len2 = glm::dot(normal, normal);
+            dst.Normal = len2 > 0.0f ? normal / std::sqrt(len2) : src.Normal;
+        }
+    }
+
+    void JointPaletteBuffer::init() {
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        GpuMemory::bufferData(ubo, GL_UNIFORM_BUFFER, kMaxGpuJoints * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW,
+            MemoryTag::GpuStreamBuffers);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void JointPaletteBuffer::shutdown() {
+        if (ubo) GpuMemory::deleteBuffers(1, &ubo);
+        ubo = 0;
+    }
+
+    void JointPaletteBuffer::upload(const std::vector<glm::mat4>& palette) {
+        upload(palette.data(), palette.size());
+    }
+
+    void JointPaletteBuffer::upload(const glm::mat4* palette, size_t count) {
+        count = std::min<size_t>(count, kMaxGpuJoints);
+        if (!ubo || count == 0) return;
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, count * sizeof(glm::mat4), palette);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void JointPaletteBuffer::bind() const {
+        glBindBufferBase(GL_UNIFORM_BUFFER, kBindingPoint, ubo);
+    }
+
+    void Animator::update(const Model& model, float deltaSeconds) {
+        const Skeleton& skeleton = model.GetSkeleton();
+        const auto& clips = model.GetAnimations();
+        if (!skeleton.hasJoints()) {
+            if (!jointPalette.empty()) ++revision;
+            jointPalette.clear();
+            return;
+        }
+        if (clip >= static_cast<int>(clips.size())) clip = 0;
+        if (blendClip >= static_cast<int>(clips.size())) blendClip = -1;
+
+        ResetPose(skeleton, pose);
+        if (!clips.empty()) {
+            const AnimationClip& active = clips[clip];
+            if (playing && active.duration > 0.0f) {
+                time = std::fmod(time + deltaSeconds * speed, active.duration);
+                if (time < 0.0f) time += active.duration;
+            }
+            cursor.retarget(clip, model.GetRevision());
+            SampleClip(active, time, cursor, pose);
+
+            if (blendClip >= 0 && blendWeight > 0.0f) {
+                const AnimationClip& other = clips[blendClip];
+                float otherTime = other.duration > 0.0f ? std::fmod(time, other.duration) : 0.0f;
+                ResetPose(skeleton, blendPose);
+                blendCursor.retarget(blendClip, model.GetRevision());
+                SampleClip(other, otherTime, blendCursor, blendPose);
+                BlendPoses(pose, blendPose, blendWeight, pose);
+            }
+        }
+        ComputeSkinningMatrices(skeleton, pose, globals, jointPalette);
+
+        if (mode != previousMode || jointPalette != previousPalette) {
+            ++revision;
+            previousMode = mode;
+            previousPalette = jointPalette;
+        }
+    }
+
+    SkinningMode Animator::apply(Model& model, JointPaletteBuffer& paletteBuffer) const {
+        if (jointPalette.empty()) return SkinningMode::None;
+        SkinningMode effective = mode;
+        if (effective == SkinningMode::Gpu && jointPalette.size() > kMaxGpuJoints) {
+            effective = SkinningMode::Cpu; // palette does not fit the uniform block
+        }
+        if (effective == SkinningMode::Gpu) {
+            paletteBuffer.upload(jointPalette);
+            paletteBuffer.bind();
+        }
+        else if (effective == SkinningMode::Cpu) {
+            model.UpdateCpuSkinning(jointPalette);
+        }
+        return effective;
+    }
+
+    void Animator::renderImGui(const Model& model) {
+        ImGui::Begin("Animation");
+        const Skeleton& skeleton = model.GetSkeleton();
+        const auto& clips = model.GetAnimations();
+        if (!skeleton.hasJoints()) {
+            ImGui::Text("Current model has no skin");
+            ImGui::End();
+            return;
+        }
+        ImGui::Text("Joints: %zu  Nodes: %zu  Clips: %zu", skeleton.jointNodes.size(), skeleton.nodeCount(), clips.size());
+
+        int modeIndex = static_cast<int>(mode);
+        const char* modes[] = { "Bind Pose", "GPU (UBO palette)", "CPU (SIMD, threaded)" };
+        if (ImGui::Combo("Skinning", &modeIndex, modes, IM_ARRAYSIZE(modes))) {
+            mode = static_cast<SkinningMode>(modeIndex);
+        }
+        if (mode == SkinningMode::Cpu) {
+            ImGui::Text("CPU skinning: %.3f ms for %zu vertices", model.GetCpuSkinningMs(), model.GetSkinnedVertexCount());
+        }
+
+        if (clips.empty()) {
+            ImGui::Text("No animation clips, showing the rest pose");
+            ImGui::End();
+            return;
+        }
+        auto clipName = [&](int i) { return clips[i].name.empty() ? "(unnamed)" : clips[i].name.c_str(); };
+        if (ImGui::BeginCombo("Clip", clipName(clip))) {
+            for (int i = 0; i < static_cast<int>(clips.size()); ++i) {
+                if (ImGui::Selectable(clipName(i), clip == i)) clip = i;
+            }
+            ImGui::EndCombo();
+        }
+        if (ImGui::BeginCombo("Blend With", blendClip >= 0 ? clipName(blendClip) : "None")) {
+            if (ImGui::Selectable("None", blendClip < 0)) blendClip = -1;
+            for (int i = 0; i < static_cast<int>(clips.size()); ++i) {
+                if (ImGui::Selectable(clipName(i), blendClip == i)) blendClip = i;
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SliderFloat("Blend Weight", &blendWeight, 0.0f, 1.0f);
+        ImGui::Checkbox("Playing", &playing);
+        ImGui::SameLine();
+        ImGui::SliderFloat("Speed", &speed, -2.0f, 2.0f);
+        ImGui::Text("Time: %.2f / %.2f s", time, clips[clip].duration);
+        ImGui::End();
+    }
+}
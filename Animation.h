@@ -0,0 +1,156 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+namespace SS
+{
+    struct Vertex;
+    class Model;
+
+    // Size of the JointPalette uniform block in the scene shader.
+    constexpr int kMaxGpuJoints = 128;
+
+    enum class SkinningMode {
+        None, // draw the bind pose as stored in the file
+        Gpu,  // vertex shader blends the joint palette from a UBO
+        Cpu   // SIMD skinning on the job system into a streamed vertex buffer
+    };
+
+    // Node hierarchy of a glTF file plus the joints of its first skin.
+    struct Skeleton {
+        std::vector<int> parents;         // per node, -1 for roots
+        std::vector<int> evaluationOrder; // parents always before their children
+        std::vector<glm::vec4> restTranslations;
+        std::vector<glm::vec4> restRotations; // quaternions, xyzw as in glTF
+        std::vector<glm::vec4> restScales;
+        std::vector<int> jointNodes;
+        std::vector<glm::mat4> inverseBindMatrices;
+
+        size_t nodeCount() const { return parents.size(); }
+        bool hasJoints() const { return !jointNodes.empty(); }
+    };
+
+    enum class AnimationPath {
+        Translation,
+        Rotation,
+        Scale
+    };
+
+    struct AnimationChannel {
+        int node = -1;
+        AnimationPath path = AnimationPath::Translation;
+        bool step = false; // STEP interpolation, otherwise linear
+        std::vector<float> times;
+        std::vector<glm::vec4> values;
+    };
+
+    struct AnimationClip {
+        std::string name;
+        float duration = 0.0f;
+        std::vector<AnimationChannel> channels;
+    };
+
+    // Local transforms of every node, stored SoA so blending streams through memory.
+    struct Pose {
+        std::vector<glm::vec4> translations;
+        std::vector<glm::vec4> rotations;
+        std::vector<glm::vec4> scales;
+    };
+
+    // Non-owning view of one pose inside a larger buffer (e.g. a crowd's SoA arrays).
+    struct PoseView {
+        glm::vec4* translations = nullptr;
+        glm::vec4* rotations = nullptr;
+        glm::vec4* scales = nullptr;
+        size_t count = 0;
+    };
+
+    inline PoseView MakePoseView(Pose& pose) {
+        return { pose.translations.data(), pose.rotations.data(), pose.scales.data(), pose.translations.size() };
+    }
+
+    // Last keyframe used by each channel. Playback moves a key or two per frame,
+    // in either direction, so the next sample steps the cursor instead of
+    // binary searching. Keys only mean something for the clip and model they
+    // were found in; retarget() restarts them when either changes.
+    struct ClipCursor {
+        std::vector<uint32_t> keys;
+        int clip = -1;
+        uint32_t modelRevision = 0;
+
+        void retarget(int clipIndex, uint32_t revision) {
+            if (clipIndex == clip && revision == modelRevision) return;
+            keys.clear();
+            clip = clipIndex;
+            modelRevision = revision;
+        }
+    };
+
+    void ResetPose(const Skeleton& skeleton, Pose& pose);
+    void ResetPose(const Skeleton& skeleton, PoseView pose);
+    // Overwrites the transforms of the nodes animated by `clip` at `time`.
+    void SampleClip(const AnimationClip& clip, float time, ClipCursor& cursor, Pose& pose);
+    // `keys` holds one cursor per channel of `clip`.
+    void SampleClip(const AnimationClip& clip, float time, uint32_t* keys, PoseView pose);
+    // out = lerp(a, b, weight), rotations by SIMD nlerp along the shortest arc.
+    void BlendPoses(const Pose& a, const Pose& b, float weight, Pose& out);
+    // Joint matrices as glTF defines them (global joint transform times inverse
+    // bind matrix); the skinned mesh's own node transform is ignored.
+    void ComputeSkinningMatrices(const Skeleton& skeleton, const Pose& pose,
+        std::vector<glm::mat4>& globals, std::vector<glm::mat4>& palette);
+    // `globals` needs nodeCount entries and `palette` one per joint.
+    void ComputeSkinningMatrices(const Skeleton& skeleton, PoseView pose, glm::mat4* globals, glm::mat4* palette);
+    // SSE linear blend skinning of positions and normals, other attributes copied.
+    void SkinVertices(const Vertex* in, Vertex* out, size_t count, const glm::mat4* palette, size_t paletteSize);
+
+    // Joint palette uniform buffer bound to the shader's JointPalette block.
+    class JointPaletteBuffer {
+    public:
+        static constexpr GLuint kBindingPoint = 0;
+
+        void init();
+        void shutdown();
+        void upload(const std::vector<glm::mat4>& palette);
+        void upload(const glm::mat4* palette, size_t count);
+        void bind() const;
+
+    private:
+        GLuint ubo = 0;
+    };
+
+    // Playback state of one animated instance.
+    class Animator {
+    public:
+        int clip = 0;
+        int blendClip = -1;
+        float blendWeight = 0.0f;
+        float speed = 1.0f;
+        bool playing = true;
+        SkinningMode mode = SkinningMode::Gpu;
+
+        void update(const Model& model, float deltaSeconds);
+        // Pushes the palette to the model via the selected skinning path and
+        // returns the mode the model's draws should use.
+        SkinningMode apply(Model& model, JointPaletteBuffer& paletteBuffer) const;
+        const std::vector<glm::mat4>& palette() const { return jointPalette; }
+        // Changes whenever the skinned shape may have changed (new palette or mode).
+        uint32_t poseRevision() const { return revision; }
+
+        void renderImGui(const Model& model);
+
+    private:
+        float time = 0.0f;
+        ClipCursor cursor;
+        ClipCursor blendCursor;
+        Pose pose;
+        Pose blendPose;
+        std::vector<glm::mat4> globals;
+        std::vector<glm::mat4> jointPalette;
+        std::vector<glm::mat4> previousPalette;
+        SkinningMode previousMode = SkinningMode::None;
+        uint32_t revision = 0;
+    };
+}
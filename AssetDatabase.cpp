@@ -0,0 +1,381 @@
+#include "AssetDatabase.h"
+#include "SceneSaver.h"
+#include "Profiler.h"
+#include "miniaudio.h"
+#include "Timing.h"
+#include "Hash.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace SS
+{
+    namespace
+    {
+        constexpr int kIndexVersion = 1;
+
+        uint64_t hashFile(const std::string& path, const std::atomic<bool>& quit) {
+            std::ifstream in(path, std::ios::binary);
+            std::vector<char> chunk(64 * 1024);
+            uint64_t hash = kFnv1aOffset;
+            while (in && !quit.load(std::memory_order_relaxed)) {
+                in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                hash = fnv1a(chunk.data(), static_cast<size_t>(in.gcount()), hash);
+            }
+            return hash;
+        }
+
+        // Triangles of all triangle-list primitives, read from the GLB's JSON
+        // chunk alone; buffers and images are never loaded
+        int64_t countTriangles(const std::string& path) {
+            std::ifstream in(path, std::ios::binary);
+            uint32_t header[5] = {}; // magic, version, length, JSON chunk length, JSON chunk type
+            if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) return -1;
+            constexpr uint32_t kGlbMagic = 0x46546C67; // "glTF"
+            constexpr uint32_t kJsonChunk = 0x4E4F534A; // "JSON"
+            if (header[0] != kGlbMagic || header[4] != kJsonChunk || header[3] > header[2]) return -1;
+            std::string text(header[3], '\0');
+            if (!in.read(&text[0], static_cast<std::streamsize>(text.size()))) return -1;
+
+            json doc = json::parse(text, nullptr, false);
+            if (doc.is_discarded() || !doc.contains("meshes") || !doc.contains("accessors")) return -1;
+            int64_t triangles = 0;
+            try {
+                const json& accessors = doc["accessors"];
+                for (const auto& mesh : doc["meshes"]) {
+                    for (const auto& prim : mesh.value("primitives", json::array())) {
+                        if (prim.value("mode", 4) != 4) continue;
+                        auto attributes = prim.find("attributes");
+                        int accessor = prim.value("indices", -1);
+                        if (accessor < 0 && attributes != prim.end() && attributes->is_object()) {
+                            accessor = attributes->value("POSITION", -1);
+                        }
+                        if (accessor < 0 || accessor >= static_cast<int>(accessors.size())) continue;
+                        triangles += accessors[accessor].value("count", int64_t(0)) / 3;
+                    }
+                }
+            }
+            catch (...) {
+                return -1;
+            }
+            return triangles;
+        }
+
+        double audioDuration(const std::string& path) {
+            ma_decoder decoder;
+            if (ma_decoder_init_file(path.c_str(), nullptr, &decoder) != MA_SUCCESS) return -1.0;
+            ma_uint64 frames = 0;
+            double seconds = -1.0;
+            if (ma_decoder_get_length_in_pcm_frames(&decoder, &frames) == MA_SUCCESS && decoder.outputSampleRate > 0) {
+                seconds = static_cast<double>(frames) / decoder.outputSampleRate;
+            }
+            ma_decoder_uninit(&decoder);
+            return seconds;
+        }
+
+        bool hasPrefix(const std::string& path, const std::string& prefix) {
+            return path.compare(0, prefix.size(), prefix) == 0;
+        }
+    }
+
+    struct AssetDatabase::Watcher {
+#ifdef _WIN32
+        std::vector<HANDLE> handles;
+        std::vector<std::string> roots; // parallel to handles
+#elif defined(__linux__)
+        int fd = -1;
+        std::map<int, std::string> directories; // watch descriptor -> directory
+#endif
+        bool active = false;
+    };
+
+    AssetDatabase::AssetDatabase(std::string modelDirectory, std::string musicDirectory, std::string indexPath)
+        : modelDirectory(fs::path(modelDirectory).generic_string()),
+          musicDirectory(fs::path(musicDirectory).generic_string()),
+          indexPath(std::move(indexPath)) {
+        worker = std::thread(&AssetDatabase::workerLoop, this);
+    }
+
+    AssetDatabase::~AssetDatabase() {
+        quit.store(true);
+        worker.join();
+    }
+
+    bool AssetDatabase::takeUpdate(std::vector<AssetInfo>& models, std::vector<AssetInfo>& music) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (publishedRevision == takenRevision) return false;
+        models = publishedModels;
+        music = publishedMusic;
+        takenRevision = publishedRevision;
+        return true;
+    }
+
+    void AssetDatabase::workerLoop() {
+        Profiler::setThreadName("Asset Database");
+        // Last session's index goes out first so the editor lists assets at once;
+        // the walk below then corrects whatever changed while the editor was closed
+        if (loadIndex()) publish();
+
+        watcher = std::make_unique<Watcher>();
+#ifdef _WIN32
+        for (const std::string& root : { modelDirectory, musicDirectory }) {
+            HANDLE handle = FindFirstChangeNotificationA(root.c_str(), TRUE,
+                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+            if (handle == INVALID_HANDLE_VALUE) continue;
+            watcher->handles.push_back(handle);
+            watcher->roots.push_back(root);
+        }
+        watcher->active = watcher->handles.size() == 2;
+        if (watcher->active) watcherKind.store("change notifications");
+#elif defined(__linux__)
+        watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        watcher->active = watcher->fd >= 0;
+        if (watcher->active) watcherKind.store("inotify");
+#endif
+
+        dirtyPaths.insert(modelDirectory);
+        dirtyPaths.insert(musicDirectory);
+        lastChange = Clock::time_point{};
+        Clock::time_point lastPoll = Clock::now();
+        while (!quit.load()) {
+            collectChanges(100);
+            if (!watcher->active && elapsedMs(lastPoll) >= kPollIntervalMs) {
+                dirtyPaths.insert(modelDirectory);
+                dirtyPaths.insert(musicDirectory);
+                lastPoll = Clock::now();
+            }
+            if (dirtyPaths.empty() || elapsedMs(lastChange) < kSettleMs) continue;
+
+            SS_PROFILE_SCOPE("AssetDatabase::refresh");
+            auto start = Clock::now();
+            std::set<std::string> paths;
+            paths.swap(dirtyPaths);
+            bool changed = false;
+            for (const std::string& path : paths) changed |= refresh(path);
+            if (quit.load()) break;
+            scanMs.store(elapsedMs(start));
+            if (changed) {
+                publish();
+                saveIndex();
+            }
+        }
+
+#ifdef _WIN32
+        for (HANDLE handle : watcher->handles) FindCloseChangeNotification(handle);
+#elif defined(__linux__)
+        if (watcher->fd >= 0) close(watcher->fd);
+#endif
+        watcher.reset();
+    }
+
+    void AssetDatabase::collectChanges(int timeoutMs) {
+        if (!watcher->active) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+            return;
+        }
+#ifdef _WIN32
+        DWORD result = WaitForMultipleObjects(static_cast<DWORD>(watcher->handles.size()), watcher->handles.data(),
+            FALSE, static_cast<DWORD>(timeoutMs));
+        if (result >= WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + watcher->handles.size()) {
+            // Notifications do not say what changed, the root is walked again;
+            // unchanged files cost a stat
+            size_t index = result - WAIT_OBJECT_0;
+            dirtyPaths.insert(watcher->roots[index]);
+            lastChange = Clock::now();
+            FindNextChangeNotification(watcher->handles[index]);
+        }
+#elif defined(__linux__)
+        pollfd pfd{ watcher->fd, POLLIN, 0 };
+        if (poll(&pfd, 1, timeoutMs) <= 0) return;
+        alignas(inotify_event) char buffer[16 * 1024];
+        for (;;) {
+            ssize_t length = read(watcher->fd, buffer, sizeof(buffer));
+            if (length <= 0) break;
+            for (char* p = buffer; p < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    dirtyPaths.insert(modelDirectory);
+                    dirtyPaths.insert(musicDirectory);
+                    continue;
+                }
+                auto it = watcher->directories.find(event->wd);
+                if (it == watcher->directories.end()) continue;
+                if (event->mask & IN_IGNORED) {
+                    watcher->directories.erase(it);
+                    continue;
+                }
+                dirtyPaths.insert(event->len > 0 ? it->second + "/" + event->name : it->second);
+            }
+            lastChange = Clock::now();
+        }
+#endif
+    }
+
+    void AssetDatabase::watchDirectory(const std::string& directory) {
+#if defined(__linux__)
+        if (!watcher || !watcher->active) return;
+        int wd = inotify_add_watch(watcher->fd, directory.c_str(),
+            IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF);
+        if (wd >= 0) watcher->directories[wd] = directory;
+#else
+        (void)directory;
+#endif
+    }
+
+    bool AssetDatabase::refresh(const std::string& path) {
+        std::error_code ec;
+        fs::file_status status = fs::status(path, ec);
+        bool changed = false;
+        if (fs::is_directory(status)) {
+            watchDirectory(path);
+            std::set<std::string> seen;
+            fs::recursive_directory_iterator it(path, ec), end;
+            for (; !ec && it != end && !quit.load(); it.increment(ec)) {
+                std::string entryPath = it->path().generic_string();
+                std::error_code entryError;
+                if (it->is_directory(entryError)) {
+                    watchDirectory(entryPath);
+                    continue;
+                }
+                AssetKind kind;
+                if (!isTracked(entryPath, kind)) continue;
+                seen.insert(entryPath);
+                changed |= updateFile(entryPath);
+            }
+            if (ec) {
+                std::cerr << "Warning: Cannot scan " << path << " folder\n";
+                return changed;
+            }
+            // Entries below the directory that the walk did not meet are gone
+            std::string prefix = path + "/";
+            for (auto entry = entries.lower_bound(prefix); entry != entries.end() && hasPrefix(entry->first, prefix);) {
+                if (seen.count(entry->first)) {
+                    ++entry;
+                    continue;
+                }
+                entry = entries.erase(entry);
+                changed = true;
+            }
+        }
+        else if (fs::exists(status)) {
+            changed = updateFile(path);
+        }
+        else {
+            // Removed or moved away: the file itself, or all that was below it
+            changed = entries.erase(path) > 0;
+            std::string prefix = path + "/";
+            for (auto entry = entries.lower_bound(prefix); entry != entries.end() && hasPrefix(entry->first, prefix);) {
+                entry = entries.erase(entry);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    bool AssetDatabase::isTracked(const std::string& path, AssetKind& kind) const {
+        std::string extension = fs::path(path).extension().string();
+        if (hasPrefix(path, modelDirectory + "/")) {
+            kind = AssetKind::Model;
+            return extension == ".glb";
+        }
+        if (hasPrefix(path, musicDirectory + "/")) {
+            kind = AssetKind::Music;
+            return extension == ".wav" || extension == ".ogg" || extension == ".mp3";
+        }
+        return false;
+    }
+
+    bool AssetDatabase::updateFile(const std::string& path) {
+        AssetKind kind;
+        if (!isTracked(path, kind)) return false;
+        std::error_code ec;
+        uint64_t size = fs::file_size(path, ec);
+        int64_t mtime = ec ? 0 : static_cast<int64_t>(fs::last_write_time(path, ec).time_since_epoch().count());
+        if (ec) return entries.erase(path) > 0;
+
+        auto existing = entries.find(path);
+        if (existing != entries.end() && existing->second.size == size && existing->second.mtime == mtime) return false;
+
+        AssetInfo info;
+        info.path = path;
+        info.kind = kind;
+        info.size = size;
+        info.mtime = mtime;
+        info.hash = hashFile(path, quit);
+        if (kind == AssetKind::Model) info.triangles = countTriangles(path);
+        else info.durationSeconds = audioDuration(path);
+        hashed.fetch_add(1);
+        entries[path] = std::move(info);
+        return true;
+    }
+
+    void AssetDatabase::publish() {
+        std::vector<AssetInfo> models, music;
+        for (const auto& entry : entries) {
+            (entry.second.kind == AssetKind::Model ? models : music).push_back(entry.second);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        publishedModels.swap(models);
+        publishedMusic.swap(music);
+        ++publishedRevision;
+    }
+
+    bool AssetDatabase::loadIndex() {
+        std::ifstream ifs(indexPath);
+        if (!ifs.is_open()) return false;
+        json doc = json::parse(ifs, nullptr, false);
+        if (doc.is_discarded() || doc.value("version", 0) != kIndexVersion || !doc.contains("assets")) return false;
+        try {
+            for (const auto& a : doc["assets"]) {
+                AssetInfo info;
+                info.path = a.at("path").get<std::string>();
+                info.kind = a.at("kind").get<std::string>() == "music" ? AssetKind::Music : AssetKind::Model;
+                info.size = a.at("size").get<uint64_t>();
+                info.mtime = a.at("mtime").get<int64_t>();
+                info.hash = a.at("hash").get<uint64_t>();
+                info.triangles = a.value("triangles", int64_t(-1));
+                info.durationSeconds = a.value("duration", -1.0);
+                AssetKind kind;
+                if (isTracked(info.path, kind) && kind == info.kind) entries[info.path] = std::move(info);
+            }
+        }
+        catch (...) {
+            std::cerr << "Ignoring damaged asset index: " << indexPath << "\n";
+            entries.clear();
+            return false;
+        }
+        return true;
+    }
+
+    void AssetDatabase::saveIndex() const {
+        json assets = json::array();
+        for (const auto& entry : entries) {
+            const AssetInfo& a = entry.second;
+            assets.push_back({
+                { "path", a.path },
+                { "kind", a.kind == AssetKind::Music ? "music" : "model" },
+                { "size", a.size },
+                { "mtime", a.mtime },
+                { "hash", a.hash },
+                { "triangles", a.triangles },
+                { "duration", a.durationSeconds }
+                });
+        }
+        SceneSaver::writeAtomically(indexPath, json{ { "version", kIndexVersion }, { "assets", assets } }.dump());
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace SS
+{
+    enum class AssetKind : uint8_t {
+        Model,
+        Music
+    };
+
+    struct AssetInfo {
+        std::string path; // forward slashes, relative to the working directory
+        AssetKind kind = AssetKind::Model;
+        uint64_t size = 0;
+        int64_t mtime = 0; // filesystem clock ticks
+        uint64_t hash = 0; // FNV-1a of the contents
+        int64_t triangles = -1;        // models, -1 when unknown
+        double durationSeconds = -1.0; // music, -1 when unknown
+    };
+
+    // Models and music under two asset roots, scanned recursively on a worker
+    // thread. Metadata is kept in an on-disk index and only recomputed for
+    // files whose size or mtime changed, so a restart costs a directory walk.
+    // Changes are picked up live: inotify on Linux, directory change
+    // notifications on Windows, and a periodic rescan elsewhere.
+    class AssetDatabase {
+    public:
+        // Changes are applied once the watched paths were quiet this long, so a
+        // file still being copied is not hashed half-written
+        static constexpr double kSettleMs = 250.0;
+        static constexpr double kPollIntervalMs = 2000.0;
+
+        AssetDatabase(std::string modelDirectory, std::string musicDirectory, std::string indexPath);
+        ~AssetDatabase();
+
+        AssetDatabase(const AssetDatabase&) = delete;
+        AssetDatabase& operator=(const AssetDatabase&) = delete;
+
+        // Copies the asset lists, sorted by path, when they changed since the
+        // last call that returned true.
+        bool takeUpdate(std::vector<AssetInfo>& models, std::vector<AssetInfo>& music);
+
+        // Watcher in use: "inotify", "change notifications" or "polling".
+        const char* watcherName() const { return watcherKind.load(); }
+        double lastScanMs() const { return scanMs.load(); }
+        int filesHashed() const { return hashed.load(); }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        std::string modelDirectory;
+        std::string musicDirectory;
+        std::string indexPath;
+
+        // Worker only
+        std::map<std::string, AssetInfo> entries;
+        std::set<std::string> dirtyPaths;
+        Clock::time_point lastChange;
+
+        // Shared with the UI thread
+        std::mutex mutex;
+        std::vector<AssetInfo> publishedModels;
+        std::vector<AssetInfo> publishedMusic;
+        uint64_t publishedRevision = 0;
+        uint64_t takenRevision = 0;
+
+        std::thread worker;
+        std::atomic<bool> quit{ false };
+        std::atomic<double> scanMs{ 0.0 };
+        std::atomic<int> hashed{ 0 };
+        std::atomic<const char*> watcherKind{ "polling" };
+
+        struct Watcher;
+        std::unique_ptr<Watcher> watcher; // worker only
+
+        void workerLoop();
+        bool loadIndex();
+        void saveIndex() const;
+        void publish();
+        // Brings entries at or below `path` in line with the disk
+        bool refresh(const std::string& path);
+        bool updateFile(const std::string& path);
+        bool isTracked(const std::string& path, AssetKind& kind) const;
+        void watchDirectory(const std::string& directory);
+        void collectChanges(int timeoutMs);
+    };
+}
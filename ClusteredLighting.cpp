@@ -0,0 +1,407 @@
+#include "ClusteredLighting.h"
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include "Timing.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SS_CLUSTER_SSE 1
+#endif
+
+namespace SS
+{
+    namespace
+    {
+        constexpr int kTilesPerSlice = ClusteredLighting::kTilesX * ClusteredLighting::kTilesY;
+        constexpr int kSweepCounts[] = { 1, 10, 50, 100, 250, 500, 1000 };
+        constexpr int kSweepSteps = sizeof(kSweepCounts) / sizeof(kSweepCounts[0]);
+        constexpr int kSweepWarmupFrames = 30;
+        constexpr int kSweepMeasureFrames = 90;
+
+        // Lights overlapping one depth slice, reused by every job on a thread
+        struct SliceLights {
+            std::vector<float> x, y, depth, radiusSq;
+            std::vector<uint16_t> index;
+        };
+        thread_local SliceLights tlsSliceLights;
+
+        uint32_t nextRandom(uint32_t& seed) {
+            seed = seed * 1664525u + 1013904223u;
+            return seed;
+        }
+
+        float random01(uint32_t& seed) {
+            return static_cast<float>(nextRandom(seed) >> 8) / static_cast<float>(1u << 24);
+        }
+
+        // Lights scattered in a shell around `center`, with saturated random colors
+        void scatterLights(std::vector<PointLight>& lights, int count, const glm::vec3& center, float radius, uint32_t seed) {
+            lights.resize(count);
+            for (auto& light : lights) {
+                glm::vec3 offset(random01(seed) * 2.0f - 1.0f, random01(seed), random01(seed) * 2.0f - 1.0f);
+                light.position = center + offset * radius * 1.5f;
+                float hue = random01(seed) * 6.0f;
+                light.color = glm::clamp(glm::vec3(std::abs(hue - 3.0f) - 1.0f, 2.0f - std::abs(hue - 2.0f),
+                    2.0f - std::abs(hue - 4.0f)), 0.0f, 1.0f);
+                light.radius = std::max(radius * 0.5f, 0.1f);
+                light.intensity = 1.0f;
+            }
+        }
+
+        void createTextureBuffer(GLuint& buffer, GLuint& texture, GLenum format) {
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+            GpuMemory::bufferData(buffer, GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW, MemoryTag::GpuStreamBuffers);
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_BUFFER, texture);
+            glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+            glBindTexture(GL_TEXTURE_BUFFER, 0);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        }
+
+        void uploadTextureBuffer(GLuint buffer, const void* data, size_t bytes) {
+            glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+            // Orphan last frame's storage rather than waiting for the GPU to finish with it
+            GpuMemory::bufferData(buffer, GL_TEXTURE_BUFFER, std::max<size_t>(bytes, 16), nullptr, GL_STREAM_DRAW,
+                MemoryTag::GpuStreamBuffers);
+            if (bytes > 0) glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        }
+    }
+
+    void ClusteredLighting::init() {
+        createTextureBuffer(lightBuffer, lightTexture, GL_RGBA32F);
+        createTextureBuffer(gridBuffer, gridTexture, GL_RG32UI);
+        createTextureBuffer(indexBuffer, indexTexture, GL_R16UI);
+
+        clusterMin.resize(kClusterCount);
+        clusterMax.resize(kClusterCount);
+        lightX.resize(kMaxLights + 4);
+        lightY.resize(kMaxLights + 4);
+        lightDepth.resize(kMaxLights + 4);
+        lightRadiusSq.resize(kMaxLights + 4);
+        lightRadius.resize(kMaxLights + 4);
+        lightData.reserve(kMaxLights * 2);
+        clusterCounts.resize(kClusterCount);
+        clusterSlots.resize(static_cast<size_t>(kClusterCount) * kMaxLightsPerCluster);
+        grid.resize(kClusterCount);
+        indices.reserve(static_cast<size_t>(kClusterCount) * 8);
+    }
+
+    void ClusteredLighting::shutdown() {
+        GLuint textures[] = { lightTexture, gridTexture, indexTexture };
+        GLuint buffers[] = { lightBuffer, gridBuffer, indexBuffer };
+        glDeleteTextures(3, textures);
+        GpuMemory::deleteBuffers(3, buffers);
+        lightTexture = gridTexture = indexTexture = 0;
+        lightBuffer = gridBuffer = indexBuffer = 0;
+    }
+
+    void ClusteredLighting::buildClusterBounds(float fovY, float aspect, float nearZ, float farZ) {
+        cachedFov = fovY;
+        cachedAspect = aspect;
+        cachedNear = nearZ;
+        cachedFar = farZ;
+        nearPlane = nearZ;
+        sliceScale = kSlices / std::log(farZ / nearZ);
+
+        float tanY = std::tan(fovY * 0.5f);
+        float tanX = tanY * aspect;
+        for (int z = 0; z < kSlices; ++z) {
+            float d0 = nearZ * std::pow(farZ / nearZ, static_cast<float>(z) / kSlices);
+            float d1 = nearZ * std::pow(farZ / nearZ, static_cast<float>(z + 1) / kSlices);
+            for (int y = 0; y < kTilesY; ++y) {
+                float y0 = -1.0f + 2.0f * y / kTilesY, y1 = -1.0f + 2.0f * (y + 1) / kTilesY;
+                for (int x = 0; x < kTilesX; ++x) {
+                    float x0 = -1.0f + 2.0f * x / kTilesX, x1 = -1.0f + 2.0f * (x + 1) / kTilesX;
+                    // The tile's side planes pass through the eye, so the extremes
+                    // sit on either the near or the far face of the slice
+                    glm::vec3 lo(std::min(x0 * tanX * d0, x0 * tanX * d1), std::min(y0 * tanY * d0, y0 * tanY * d1), d0);
+                    glm::vec3 hi(std::max(x1 * tanX * d0, x1 * tanX * d1), std::max(y1 * tanY * d0, y1 * tanY * d1), d1);
+                    int cluster = x + y * kTilesX + z * kTilesPerSlice;
+                    clusterMin[cluster] = lo;
+                    clusterMax[cluster] = hi;
+                }
+            }
+        }
+    }
+
+    void ClusteredLighting::assignSlice(int slice) {
+        const int first = slice * kTilesPerSlice;
+        const float sliceNear = clusterMin[first].z;
+        const float sliceFar = clusterMax[first].z;
+
+        // Only lights whose depth range overlaps the slice take part in its tests
+        SliceLights& candidates = tlsSliceLights;
+        if (candidates.x.size() < kMaxLights + 4) {
+            candidates.x.resize(kMaxLights + 4);
+            candidates.y.resize(kMaxLights + 4);
+            candidates.depth.resize(kMaxLights + 4);
+            candidates.radiusSq.resize(kMaxLights + 4);
+            candidates.index.resize(kMaxLights + 4);
+        }
+        int count = 0;
+        for (int i = 0; i < lightCount; ++i) {
+            if (lightDepth[i] + lightRadius[i] < sliceNear || lightDepth[i] - lightRadius[i] > sliceFar) continue;
+            candidates.x[count] = lightX[i];
+            candidates.y[count] = lightY[i];
+            candidates.depth[count] = lightDepth[i];
+            candidates.radiusSq[count] = lightRadiusSq[i];
+            candidates.index[count] = static_cast<uint16_t>(i);
+            ++count;
+        }
+        // Pad to whole groups of four with lights that can never pass
+        int padded = (count + 3) & ~3;
+        for (int i = count; i < padded; ++i) {
+            candidates.x[i] = candidates.y[i] = candidates.depth[i] = 0.0f;
+            candidates.radiusSq[i] = -1.0f;
+            candidates.index[i] = 0;
+        }
+
+        for (int cluster = first; cluster < first + kTilesPerSlice; ++cluster) {
+            uint16_t* slots = &clusterSlots[static_cast<size_t>(cluster) * kMaxLightsPerCluster];
+            int hits = 0;
+            const glm::vec3& lo = clusterMin[cluster];
+            const glm::vec3& hi = clusterMax[cluster];
+#ifdef SS_CLUSTER_SSE
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 minX = _mm_set1_ps(lo.x), maxX = _mm_set1_ps(hi.x);
+            const __m128 minY = _mm_set1_ps(lo.y), maxY = _mm_set1_ps(hi.y);
+            const __m128 minZ = _mm_set1_ps(lo.z), maxZ = _mm_set1_ps(hi.z);
+            for (int i = 0; i < padded; i += 4) {
+                // Distance from each sphere center to the closest point of the box
+                __m128 x = _mm_loadu_ps(&candidates.x[i]);
+                __m128 y = _mm_loadu_ps(&candidates.y[i]);
+                __m128 z = _mm_loadu_ps(&candidates.depth[i]);
+                __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, x), _mm_sub_ps(x, maxX)), zero);
+                __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, y), _mm_sub_ps(y, maxY)), zero);
+                __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, z), _mm_sub_ps(z, maxZ)), zero);
+                __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                int mask = _mm_movemask_ps(_mm_cmple_ps(distSq, _mm_loadu_ps(&candidates.radiusSq[i])));
+                for (int lane = 0; mask && lane < 4; ++lane) {
+                    if (!(mask & (1 << lane))) continue;
+                    if (hits < kMaxLightsPerCluster) slots[hits] = candidates.index[i + lane];
+                    ++hits;
+                }
+            }
+#else
+            for (int i = 0; i < count; ++i) {
+                float dx = std::max(std::max(lo.x - candidates.x[i], candidates.x[i] - hi.x), 0.0f);
+                float dy = std::max(std::max(lo.y - candidates.y[i], candidates.y[i] - hi.y), 0.0f);
+                float dz = std::max(std::max(lo.z - candidates.depth[i], candidates.depth[i] - hi.z), 0.0f);
+                if (dx * dx + dy * dy + dz * dz > candidates.radiusSq[i]) continue;
+                if (hits < kMaxLightsPerCluster) slots[hits] = candidates.index[i];
+                ++hits;
+            }
+#endif
+            // Counts past the slot capacity are kept so the overflow can be reported
+            clusterCounts[cluster] = static_cast<uint16_t>(std::min(hits, 65535));
+        }
+    }
+
+    void ClusteredLighting::update(const std::vector<PointLight>& lights, const glm::mat4& view, float fovY, float aspect,
+        float nearZ, float farZ, JobSystem& jobs) {
+        SS_PROFILE_SCOPE("Clustered Light Assignment");
+        if (!lightBuffer) return;
+        auto start = std::chrono::steady_clock::now();
+
+        if (fovY != cachedFov || aspect != cachedAspect || nearZ != cachedNear || farZ != cachedFar) {
+            buildClusterBounds(fovY, aspect, nearZ, farZ);
+        }
+
+        const PointLight* source = lights.data();
+        int sourceCount = static_cast<int>(lights.size());
+        if (sweeping()) {
+            source = sweepLights.data();
+            sourceCount = kSweepCounts[sweepStep];
+        }
+        lightCount = enabled ? std::min(sourceCount, kMaxLights) : 0;
+
+        lightData.clear();
+        for (int i = 0; i < lightCount; ++i) {
+            const PointLight& light = source[i];
+            glm::vec3 p = glm::vec3(view * glm::vec4(light.position, 1.0f));
+            lightX[i] = p.x;
+            lightY[i] = p.y;
+            lightDepth[i] = -p.z;
+            lightRadius[i] = light.radius;
+            lightRadiusSq[i] = light.radius * light.radius;
+            lightData.push_back(glm::vec4(light.position, light.radius));
+            lightData.push_back(glm::vec4(light.color * light.intensity, 0.0f));
+        }
+
+        if (lightCount > 0) {
+            jobs.parallelFor(kSlices, 1, [this](size_t begin, size_t end) {
+                for (size_t slice = begin; slice < end; ++slice) assignSlice(static_cast<int>(slice));
+            });
+        }
+        else {
+            std::fill(clusterCounts.begin(), clusterCounts.end(), 0);
+        }
+
+        // Compact the fixed-size slots into one index list
+        indices.clear();
+        lastMaxPerCluster = 0;
+        lastOverflow = 0;
+        for (int cluster = 0; cluster < kClusterCount; ++cluster) {
+            int hits = clusterCounts[cluster];
+            int kept = std::min(hits, kMaxLightsPerCluster);
+            lastMaxPerCluster = std::max(lastMaxPerCluster, hits);
+            lastOverflow += hits - kept;
+            grid[cluster] = glm::uvec2(static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(kept));
+            const uint16_t* slots = &clusterSlots[static_cast<size_t>(cluster) * kMaxLightsPerCluster];
+            indices.insert(indices.end(), slots, slots + kept);
+        }
+        lastIndexCount = static_cast<int>(indices.size());
+        lastAssignMs = elapsedMs(start);
+    }
+
+    void ClusteredLighting::upload() {
+        if (!lightBuffer) return;
+        uploadTextureBuffer(lightBuffer, lightData.data(), lightData.size() * sizeof(glm::vec4));
+        uploadTextureBuffer(gridBuffer, grid.data(), grid.size() * sizeof(glm::uvec2));
+        uploadTextureBuffer(indexBuffer, indices.data(), indices.size() * sizeof(uint16_t));
+        uploadedLightCount = lightCount;
+        uploadedNear = nearPlane;
+        uploadedSliceScale = sliceScale;
+    }
+
+    void ClusteredLighting::applyTo(GLuint shaderProgram, int viewportWidth, int viewportHeight) const {
+        glUseProgram(shaderProgram);
+        glUniform1i(glGetUniformLocation(shaderProgram, "clusteredLighting"), uploadedLightCount > 0);
+        glUniform2f(glGetUniformLocation(shaderProgram, "clusterViewport"),
+            static_cast<float>(std::max(viewportWidth, 1)), static_cast<float>(std::max(viewportHeight, 1)));
+        glUniform3i(glGetUniformLocation(shaderProgram, "clusterDims"), kTilesX, kTilesY, kSlices);
+        glUniform2f(glGetUniformLocation(shaderProgram, "clusterDepth"), uploadedNear, uploadedSliceScale);
+
+        glActiveTexture(GL_TEXTURE0 + kLightDataUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, lightTexture);
+        glActiveTexture(GL_TEXTURE0 + kClusterGridUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+        glActiveTexture(GL_TEXTURE0 + kLightIndexUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void ClusteredLighting::startSweep(const glm::vec3& center, float radius) {
+        scatterLights(sweepLights, kSweepCounts[kSweepSteps - 1], center, radius, 0x2545F491u);
+        sweepResults.clear();
+        sweepStep = 0;
+        sweepFrameIndex = 0;
+        sweepAssignSum = sweepGpuSum = sweepPerClusterSum = 0.0;
+    }
+
+    void ClusteredLighting::sweepFrame(float sceneGpuMs) {
+        if (!sweeping()) return;
+        ++sweepFrameIndex;
+        // The GPU average trails by a few frames, so skip the start of every step
+        if (sweepFrameIndex <= kSweepWarmupFrames) return;
+
+        sweepAssignSum += lastAssignMs;
+        sweepGpuSum += sceneGpuMs;
+        sweepPerClusterSum += static_cast<double>(lastIndexCount) / kClusterCount;
+        if (sweepFrameIndex < kSweepWarmupFrames + kSweepMeasureFrames) return;
+
+        LightSweepResult result;
+        result.lights = kSweepCounts[sweepStep];
+        result.assignMs = sweepAssignSum / kSweepMeasureFrames;
+        result.sceneGpuMs = sweepGpuSum / kSweepMeasureFrames;
+        result.averagePerCluster = static_cast<float>(sweepPerClusterSum / kSweepMeasureFrames);
+        sweepResults.push_back(result);
+        std::cout << "Light sweep: " << result.lights << " lights, assign " << result.assignMs << " ms, scene GPU "
+            << result.sceneGpuMs << " ms, " << result.averagePerCluster << " lights per cluster\n";
+
+        sweepFrameIndex = 0;
+        sweepAssignSum = sweepGpuSum = sweepPerClusterSum = 0.0;
+        if (++sweepStep >= kSweepSteps) sweepStep = -1;
+    }
+
+    void ClusteredLighting::renderImGui(std::vector<PointLight>& lights, const glm::vec3& focus, float focusRadius) {
+        ImGui::Begin("Point Lights");
+        ImGui::Checkbox("Clustered Lighting", &enabled);
+        ImGui::Text("Grid: %dx%dx%d  Lights: %d", kTilesX, kTilesY, kSlices, lightCount);
+        ImGui::Text("Assign: %.3f ms  Indices: %d  Max/cluster: %d", lastAssignMs, lastIndexCount, lastMaxPerCluster);
+        if (lastOverflow > 0) {
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%d light references dropped (cluster full)", lastOverflow);
+        }
+        if (static_cast<int>(lights.size()) > kMaxLights) {
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "Only the first %d lights are shaded", kMaxLights);
+        }
+
+        ImGui::Separator();
+        ImGui::SliderInt("Count", &scatterCount, 1, kMaxLights);
+        if (ImGui::Button("Scatter Around Model")) {
+            scatterLights(lights, scatterCount, focus, focusRadius, static_cast<uint32_t>(lights.size() * 2654435761u + 1u));
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Add Light")) {
+            PointLight light;
+            light.position = focus + glm::vec3(0.0f, focusRadius, focusRadius);
+            light.radius = std::max(focusRadius, 0.1f);
+            lights.push_back(light);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Clear")) lights.clear();
+
+        if (ImGui::TreeNode("Lights", "Lights (%zu)", lights.size())) {
+            int removed = -1;
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(lights.size()));
+            while (clipper.Step()) {
+                for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                    PointLight& light = lights[i];
+                    ImGui::PushID(i);
+                    ImGui::SetNextItemWidth(200.0f);
+                    ImGui::DragFloat3("##position", &light.position.x, 0.05f);
+                    ImGui::SameLine();
+                    ImGui::ColorEdit3("##color", &light.color.x, ImGuiColorEditFlags_NoInputs);
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(60.0f);
+                    ImGui::DragFloat("##radius", &light.radius, 0.05f, 0.05f, 100.0f, "r %.2f");
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(60.0f);
+                    ImGui::DragFloat("##intensity", &light.intensity, 0.02f, 0.0f, 20.0f, "i %.2f");
+                    ImGui::SameLine();
+                    if (ImGui::SmallButton("X")) removed = i;
+                    ImGui::PopID();
+                }
+            }
+            if (removed >= 0) lights.erase(lights.begin() + removed);
+            ImGui::TreePop();
+        }
+
+        ImGui::Separator();
+        if (sweeping()) {
+            ImGui::Text("Sweeping: %d lights (%d / %d)", kSweepCounts[sweepStep], sweepStep + 1, kSweepSteps);
+        }
+        else if (ImGui::Button("Run Light Sweep (1 - 1000)")) {
+            startSweep(focus, focusRadius);
+        }
+        if (!sweepResults.empty() && ImGui::BeginTable("LightSweep", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Lights");
+            ImGui::TableSetupColumn("Assign ms");
+            ImGui::TableSetupColumn("Scene GPU ms");
+            ImGui::TableSetupColumn("Avg / cluster");
+            ImGui::TableHeadersRow();
+            for (const auto& result : sweepResults) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", result.lights);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", result.assignMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", result.sceneGpuMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", result.averagePerCluster);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+}
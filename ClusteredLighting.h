@@ -0,0 +1,103 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "SceneManager.h"
+
+namespace SS
+{
+    class JobSystem;
+
+    struct LightSweepResult {
+        int lights = 0;
+        double assignMs = 0.0;   // CPU cluster build and upload
+        double sceneGpuMs = 0.0; // scene pass as measured by the GPU profiler
+        float averagePerCluster = 0.0f;
+    };
+
+    // Clustered forward shading for point lights. The view frustum is split into
+    // tiles x exponential depth slices; every frame the lights are assigned to the
+    // clusters they touch on the CPU (SSE sphere-vs-AABB, four lights per test,
+    // slices spread over the job system) and the result is uploaded to texture
+    // buffers. Each fragment then only shades the lights listed for its cluster.
+    class ClusteredLighting {
+    public:
+        static constexpr int kTilesX = 16;
+        static constexpr int kTilesY = 9;
+        static constexpr int kSlices = 24;
+        static constexpr int kClusterCount = kTilesX * kTilesY * kSlices;
+        static constexpr int kMaxLights = 1024;
+        static constexpr int kMaxLightsPerCluster = 256;
+
+        static constexpr GLuint kLightDataUnit = 2;
+        static constexpr GLuint kClusterGridUnit = 3;
+        static constexpr GLuint kLightIndexUnit = 4;
+
+        bool enabled = true;
+
+        void init();
+        void shutdown();
+
+        // Assigns `lights` to the clusters of this frame's camera. CPU only, so it
+        // may run on the update thread.
+        void update(const std::vector<PointLight>& lights, const glm::mat4& view, float fovY, float aspect,
+            float nearPlane, float farPlane, JobSystem& jobs);
+        // Uploads the last update's grid; applyTo() only uses uploaded state.
+        void upload();
+        // Binds the buffers and sets the cluster uniforms; `viewportWidth/Height`
+        // is the size the scene is rasterized at.
+        void applyTo(GLuint shaderProgram, int viewportWidth, int viewportHeight) const;
+
+        // The sweep replaces the scene's lights with 1 ... 1000 generated ones
+        // around `center`, holding each count for a fixed number of frames.
+        void startSweep(const glm::vec3& center, float radius);
+        bool sweeping() const { return sweepStep >= 0; }
+        void sweepFrame(float sceneGpuMs);
+
+        // Light editor for the current scene, plus the sweep controls.
+        void renderImGui(std::vector<PointLight>& lights, const glm::vec3& focus, float focusRadius);
+
+    private:
+        GLuint lightBuffer = 0, lightTexture = 0;
+        GLuint gridBuffer = 0, gridTexture = 0;
+        GLuint indexBuffer = 0, indexTexture = 0;
+
+        // View-space cluster bounds, x/y as in view space and z as positive depth
+        std::vector<glm::vec3> clusterMin;
+        std::vector<glm::vec3> clusterMax;
+        float cachedFov = 0.0f, cachedAspect = 0.0f, cachedNear = 0.0f, cachedFar = 0.0f;
+        float nearPlane = 0.1f;
+        float sliceScale = 1.0f; // slices / log(far / near)
+
+        // Light SoA in view space, depth positive
+        std::vector<float> lightX, lightY, lightDepth, lightRadiusSq, lightRadius;
+        std::vector<glm::vec4> lightData; // world position + radius, color * intensity
+        std::vector<uint16_t> clusterCounts;
+        std::vector<uint16_t> clusterSlots; // kMaxLightsPerCluster per cluster
+        std::vector<glm::uvec2> grid;       // offset, count
+        std::vector<uint16_t> indices;
+        int lightCount = 0;
+        int uploadedLightCount = 0;
+        float uploadedNear = 0.1f;
+        float uploadedSliceScale = 1.0f;
+
+        double lastAssignMs = 0.0;
+        int lastMaxPerCluster = 0;
+        int lastOverflow = 0;
+        int lastIndexCount = 0;
+
+        int sweepStep = -1;
+        int sweepFrameIndex = 0;
+        double sweepAssignSum = 0.0;
+        double sweepGpuSum = 0.0;
+        double sweepPerClusterSum = 0.0;
+        std::vector<PointLight> sweepLights;
+        std::vector<LightSweepResult> sweepResults;
+
+        int scatterCount = 64;
+
+        void buildClusterBounds(float fovY, float aspect, float nearZ, float farZ);
+        void assignSlice(int slice);
+    };
+}
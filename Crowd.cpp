@@ -0,0 +1,253 @@
+#include "Crowd.h"
+#include "ModelManager.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Timing.h"
+#include <imgui.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+namespace SS
+{
+    namespace
+    {
+        constexpr size_t kInstancesPerJob = 16;
+
+        // Hierarchy scratch, one per thread so jobs never allocate once warmed up
+        thread_local std::vector<glm::mat4> tlsGlobals;
+
+        glm::mat4* globalsScratch(size_t nodes) {
+            if (tlsGlobals.size() < nodes) tlsGlobals.resize(nodes);
+            return tlsGlobals.data();
+        }
+
+        // Left, right, bottom, top, near, far planes of a view-projection matrix
+        void extractFrustum(const glm::mat4& m, glm::vec4 planes[6]) {
+            glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+            glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+            glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+            glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+            planes[0] = row3 + row0;
+            planes[1] = row3 - row0;
+            planes[2] = row3 + row1;
+            planes[3] = row3 - row1;
+            planes[4] = row3 + row2;
+            planes[5] = row3 - row2;
+            for (int i = 0; i < 6; ++i) {
+                planes[i] /= glm::length(glm::vec3(planes[i]));
+            }
+        }
+
+        bool sphereInFrustum(const glm::vec4 planes[6], const glm::vec3& center, float radius) {
+            for (int i = 0; i < 6; ++i) {
+                if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) return false;
+            }
+            return true;
+        }
+    }
+
+    void CrowdAnimation::bind(const Model& model, int count) {
+        const Skeleton& skeleton = model.GetSkeleton();
+        const auto& clips = model.GetAnimations();
+
+        boundRevision = model.GetRevision();
+        nodes = skeleton.nodeCount();
+        joints = skeleton.jointNodes.size();
+        clipCount = clips.size();
+        channelStride = 0;
+        for (const auto& clip : clips) {
+            channelStride = std::max(channelStride, clip.channels.size());
+        }
+
+        // Bind pose bounds of the whole model, padded for limbs swinging out
+        glm::vec3 lo(0.0f), hi(0.0f);
+        model.GetBounds(lo, hi);
+        boundsCenter = (lo + hi) * 0.5f;
+        boundsRadius = std::max(0.01f, glm::length(hi - lo) * 0.75f);
+        footprint = std::max(0.1f, std::max(hi.x - lo.x, hi.z - lo.z));
+
+        size_t n = static_cast<size_t>(std::max(count, 0));
+        positions.resize(n);
+        times.resize(n);
+        speeds.resize(n);
+        pendingSeconds.assign(n, 0.0f);
+        visible.assign(n, 1);
+        translations.resize(n * nodes);
+        rotations.resize(n * nodes);
+        scales.resize(n * nodes);
+        cursorKeys.assign(n * channelStride, 0);
+        palettes.assign(n * joints, glm::mat4(1.0f));
+
+        // Square grid behind the origin, with varied phase and speed so the copies
+        // do not move in lockstep
+        int columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<float>(n)))));
+        uint32_t seed = 0x9E3779B9u;
+        auto random01 = [&seed]() {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        };
+        for (size_t i = 0; i < n; ++i) {
+            int column = static_cast<int>(i) % columns;
+            int row = static_cast<int>(i) / columns;
+            positions[i] = glm::vec3((column - columns / 2) * footprint, 0.0f, -(row + 1) * footprint);
+            times[i] = random01() * 10.0f;
+            speeds[i] = 0.8f + random01() * 0.4f;
+        }
+        frameIndex = 0;
+    }
+
+    void CrowdAnimation::evaluate(const Model& model, size_t instance, float deltaSeconds, glm::mat4* globals) {
+        const Skeleton& skeleton = model.GetSkeleton();
+        const auto& clips = model.GetAnimations();
+        PoseView pose{ &translations[instance * nodes], &rotations[instance * nodes], &scales[instance * nodes], nodes };
+
+        ResetPose(skeleton, pose);
+        if (clipCount > 0) {
+            const AnimationClip& clip = clips[instance % clipCount];
+            float& time = times[instance];
+            if (clip.duration > 0.0f) {
+                time = std::fmod(time + deltaSeconds * speeds[instance], clip.duration);
+            }
+            SampleClip(clip, time, &cursorKeys[instance * channelStride], pose);
+        }
+        ComputeSkinningMatrices(skeleton, pose, globals, &palettes[instance * joints]);
+    }
+
+    void CrowdAnimation::update(const Model& model, float deltaSeconds, const glm::mat4& viewProj,
+        const glm::vec3& cameraPos, JobSystem& jobs) {
+        SS_PROFILE_SCOPE("Crowd Update");
+        const Skeleton& skeleton = model.GetSkeleton();
+        // Pooled models move and reuse addresses, so the revision identifies the model
+        if (model.GetRevision() != boundRevision || nodes != skeleton.nodeCount() || joints != skeleton.jointNodes.size() ||
+            clipCount != model.GetAnimations().size() || size() != static_cast<size_t>(std::max(instanceCount, 0))) {
+            bind(model, instanceCount);
+        }
+        if (size() == 0 || !skeleton.hasJoints()) {
+            lastEvaluated = 0;
+            lastVisible = 0;
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        glm::vec4 planes[6];
+        extractFrustum(viewProj, planes);
+        const float lodDistanceSq = lodDistance * lodDistance;
+        const uint32_t interval = reducedRate ? static_cast<uint32_t>(std::max(reducedRateInterval, 1)) : 1u;
+        const uint32_t frame = frameIndex++;
+        std::atomic<int> evaluated{ 0 };
+        std::atomic<int> onScreen{ 0 };
+
+        jobs.parallelFor(size(), kInstancesPerJob, [&](size_t begin, size_t end) {
+            glm::mat4* globals = globalsScratch(nodes);
+            int evaluatedHere = 0;
+            int onScreenHere = 0;
+            for (size_t i = begin; i < end; ++i) {
+                glm::vec3 center = positions[i] * spacing + boundsCenter;
+                bool inView = sphereInFrustum(planes, center, boundsRadius);
+                visible[i] = inView;
+                onScreenHere += inView;
+                pendingSeconds[i] += deltaSeconds;
+
+                // Stagger reduced-rate instances so each frame takes a similar share
+                glm::vec3 toCamera = center - cameraPos;
+                bool fullRate = inView && glm::dot(toCamera, toCamera) <= lodDistanceSq;
+                if (!fullRate && (frame + static_cast<uint32_t>(i)) % interval != 0) continue;
+
+                evaluate(model, i, pendingSeconds[i], globals);
+                pendingSeconds[i] = 0.0f;
+                ++evaluatedHere;
+            }
+            evaluated += evaluatedHere;
+            onScreen += onScreenHere;
+        });
+
+        lastEvaluated = evaluated.load();
+        lastVisible = onScreen.load();
+        lastUpdateMs = elapsedMs(start);
+    }
+
+    glm::mat4 CrowdAnimation::modelMatrix(size_t instance) const {
+        return glm::translate(glm::mat4(1.0f), positions[instance] * spacing);
+    }
+
+    std::vector<CrowdBenchmarkResult> CrowdAnimation::runBenchmark(const Model& model, int instances, int frames) {
+        SS_PROFILE_SCOPE("Crowd Benchmark");
+        std::vector<CrowdBenchmarkResult> results;
+        if (!model.GetSkeleton().hasJoints()) return results;
+
+        // Everything in view and at full rate, so the numbers measure evaluation only
+        const glm::mat4 viewProj(1.0f);
+        const float frameSeconds = 1.0f / 60.0f;
+        unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+            JobSystem jobs(threads);
+            CrowdAnimation crowd;
+            crowd.instanceCount = instances;
+            crowd.reducedRate = false;
+            for (int i = 0; i < 5; ++i) {
+                crowd.update(model, frameSeconds, viewProj, glm::vec3(0.0f), jobs);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; ++i) {
+                crowd.update(model, frameSeconds, viewProj, glm::vec3(0.0f), jobs);
+            }
+            double msPerFrame = elapsedMs(start) / std::max(frames, 1);
+            results.push_back({ threads, msPerFrame });
+            std::cout << "Crowd benchmark: " << instances << " instances, " << threads << " thread(s): "
+                << msPerFrame << " ms/frame\n";
+            if (threads == maxThreads) break;
+        }
+        return results;
+    }
+
+    void CrowdAnimation::renderImGui(const Model& model) {
+        ImGui::Begin("Crowd");
+        if (!model.GetSkeleton().hasJoints()) {
+            ImGui::Text("Current model has no skin");
+            ImGui::End();
+            return;
+        }
+        ImGui::Checkbox("Enabled", &enabled);
+        ImGui::SliderInt("Instances", &instanceCount, 1, 1000);
+        ImGui::SliderFloat("Spacing", &spacing, 1.0f, 4.0f);
+        ImGui::Checkbox("Reduced Rate LOD", &reducedRate);
+        if (reducedRate) {
+            ImGui::SliderFloat("LOD Distance", &lodDistance, 1.0f, 100.0f);
+            ImGui::SliderInt("Update Interval", &reducedRateInterval, 2, 16);
+        }
+        if (joints > static_cast<size_t>(kMaxGpuJoints)) {
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%zu joints exceed the GPU palette, drawn in bind pose", joints);
+        }
+        if (enabled) {
+            ImGui::Text("Update: %.3f ms  Evaluated: %d / %zu  On screen: %d", lastUpdateMs, lastEvaluated, size(), lastVisible);
+        }
+
+        ImGui::Separator();
+        if (ImGui::Button("Run Benchmark (1000 instances)")) {
+            benchmarkResults = runBenchmark(model);
+        }
+        if (!benchmarkResults.empty() && ImGui::BeginTable("CrowdBenchmark", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Threads");
+            ImGui::TableSetupColumn("ms / frame");
+            ImGui::TableSetupColumn("Speedup");
+            ImGui::TableHeadersRow();
+            for (const auto& result : benchmarkResults) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", result.threads);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", result.msPerFrame);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2fx", benchmarkResults[0].msPerFrame / std::max(result.msPerFrame, 1e-6));
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Animation.h"
+
+namespace SS
+{
+    class Model;
+    class JobSystem;
+
+    struct CrowdBenchmarkResult {
+        unsigned threads = 0;
+        double msPerFrame = 0.0;
+    };
+
+    // Many animated copies of one model. Instance state and poses live in flat SoA
+    // arrays sized once per model, and the per-frame update runs as parallel jobs
+    // over instances. Instances outside the frustum or beyond `lodDistance` are only
+    // evaluated every `reducedRateInterval` frames, accumulating the skipped time.
+    class CrowdAnimation {
+    public:
+        bool enabled = false;
+        int instanceCount = 100;
+        float spacing = 1.5f; // in multiples of the model's footprint
+        float lodDistance = 15.0f;
+        int reducedRateInterval = 4;
+        bool reducedRate = true;
+
+        // Re-sizes the buffers when the model or the instance count changed.
+        void update(const Model& model, float deltaSeconds, const glm::mat4& viewProj,
+            const glm::vec3& cameraPos, JobSystem& jobs);
+
+        size_t size() const { return positions.size(); }
+        size_t jointCount() const { return joints; }
+        bool isVisible(size_t instance) const { return visible[instance] != 0; }
+        glm::mat4 modelMatrix(size_t instance) const;
+        const glm::mat4* palette(size_t instance) const { return palettes.data() + instance * joints; }
+
+        // Times `frames` full-rate updates of `instances` copies for 1, 2, 4, ...
+        // worker threads up to the hardware thread count.
+        static std::vector<CrowdBenchmarkResult> runBenchmark(const Model& model, int instances = 1000, int frames = 60);
+
+        void renderImGui(const Model& model);
+
+    private:
+        uint32_t boundRevision = 0; // Model::GetRevision() of the bound model
+        size_t nodes = 0;
+        size_t joints = 0;
+        size_t clipCount = 0;
+        size_t channelStride = 0; // cursor slots per instance, the longest clip's channel count
+        float footprint = 1.0f;
+        glm::vec3 boundsCenter{ 0.0f };
+        float boundsRadius = 1.0f;
+        uint32_t frameIndex = 0;
+
+        // Per instance
+        std::vector<glm::vec3> positions;
+        std::vector<float> times;
+        std::vector<float> speeds;
+        std::vector<float> pendingSeconds;
+        std::vector<uint8_t> visible;
+
+        // Per instance times nodes / channels / joints
+        std::vector<glm::vec4> translations;
+        std::vector<glm::vec4> rotations;
+        std::vector<glm::vec4> scales;
+        std::vector<uint32_t> cursorKeys;
+        std::vector<glm::mat4> palettes;
+
+        double lastUpdateMs = 0.0;
+        int lastEvaluated = 0;
+        int lastVisible = 0;
+        std::vector<CrowdBenchmarkResult> benchmarkResults;
+
+        void bind(const Model& model, int count);
+        void evaluate(const Model& model, size_t instance, float deltaSeconds, glm::mat4* globals);
+    };
+}
@@ -0,0 +1,203 @@
+#include "EditorCommands.h"
+#include "ResourcePools.h"
+#include "SoundManager.h"
+#include "Profiler.h"
+#include "Timing.h"
+#include <imgui.h>
+#include <iostream>
+
+namespace SS
+{
+    EditorCommandQueue::EditorCommandQueue() {
+        loader = std::thread(&EditorCommandQueue::loaderLoop, this);
+    }
+
+    EditorCommandQueue::~EditorCommandQueue() {
+        cancelLoad.store(true);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        loader.join();
+    }
+
+    void EditorCommandQueue::loadMesh(const std::string& path) {
+        ++requests;
+        if (hasPendingMesh) ++coalesced;
+        pendingMesh = path;
+        hasPendingMesh = true;
+        meshRequested = Clock::now();
+        // Whatever is importing now is no longer wanted
+        if (loadInFlight) cancelLoad.store(true);
+    }
+
+    void EditorCommandQueue::playMusic(const std::string& path) {
+        ++requests;
+        if (hasPendingMusic) ++coalesced;
+        pendingMusic = path;
+        hasPendingMusic = true;
+        musicRequested = Clock::now();
+    }
+
+    void EditorCommandQueue::loadScene(const Scene& scene) {
+        std::cout << "Loading Scene: " << scene.name << "\n";
+        loadMesh(scene.meshPath);
+        playMusic(scene.musicPath);
+        pendingLighting = scene;
+        hasPendingLighting = true;
+    }
+
+    void EditorCommandQueue::reloadMesh(const std::string& path) {
+        pendingReloads.push_back(path);
+    }
+
+    void EditorCommandQueue::startLoad(const std::string& path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            loadPath = path;
+            loadRequested = true;
+            cancelLoad.store(false);
+        }
+        wake.notify_one();
+        loadInFlight = true;
+        loadingPath = path;
+    }
+
+    void EditorCommandQueue::process(Handle<Model>& model, SoundManager& sound, std::string& currentMusic,
+        glm::vec3& lightPos, float& ambientIntensity, std::vector<PointLight>& pointLights) {
+        SS_PROFILE_SCOPE("EditorCommandQueue::process");
+        freeRetired();
+        HandlePool<Model>& models = ResourcePools::Get().models;
+
+        // A re-export only reloads the model on screen, and not over one the
+        // user has picked since
+        for (const std::string& path : pendingReloads) {
+            const Model* current = models.get(model);
+            if (!current || hasPendingMesh || (loadInFlight && loadingPath != path)) continue;
+            if (SceneManager::CanonicalPath(current->GetFilename()) != SceneManager::CanonicalPath(path)) continue;
+            std::cout << "Reloading changed model: " << path << "\n";
+            loadMesh(path);
+            ++reloads;
+        }
+        pendingReloads.clear();
+
+        if (hasPendingLighting) {
+            lightPos = pendingLighting.lightPos;
+            ambientIntensity = pendingLighting.ambientIntensity;
+            pointLights = pendingLighting.pointLights;
+            hasPendingLighting = false;
+        }
+
+        if (loadInFlight) {
+            std::unique_ptr<ModelImport> import;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (finishedReady) {
+                    import = std::move(finished);
+                    finishedReady = false;
+                    loadInFlight = false;
+                    lastImportMs = finishedMs;
+                }
+            }
+            if (!loadInFlight) {
+                // A newer request that arrived after the import finished still wins
+                if (import && !hasPendingMesh) {
+                    // Swap in a fresh model so anything holding the old handle
+                    // sees it go stale instead of reading a half-replaced model
+                    auto start = Clock::now();
+                    Handle<Model> loaded = models.emplace();
+                    models.get(loaded)->LoadFromImport(*import);
+                    retire(model);
+                    model = loaded;
+                    lastInstallMs = elapsedMs(start);
+                    ++installed;
+                }
+                else if (import || cancelLoad.load()) {
+                    ++cancelled;
+                }
+                else {
+                    std::cerr << "Failed to load model: " << loadingPath << "\n";
+                }
+            }
+        }
+
+        auto now = Clock::now();
+        auto settled = [now](Clock::time_point requested) {
+            return std::chrono::duration<double, std::milli>(now - requested).count() >= kSettleMs;
+        };
+        if (hasPendingMesh && !loadInFlight && settled(meshRequested)) {
+            startLoad(pendingMesh);
+            hasPendingMesh = false;
+        }
+        if (hasPendingMusic && settled(musicRequested)) {
+            sound.stopMusic();
+            sound.playMusic(pendingMusic);
+            currentMusic = pendingMusic;
+            hasPendingMusic = false;
+        }
+    }
+
+    void EditorCommandQueue::retire(Handle<Model> model) {
+        // Everything submitted so far may still draw the old model and nothing
+        // after this point does, so one fence covers every frame in flight.
+        // Until it signals, the model keeps its buffers and texture layers and
+        // the next load cannot recycle a layer the GPU is still sampling.
+        retired.push_back({ model, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+    }
+
+    void EditorCommandQueue::freeRetired() {
+        HandlePool<Model>& models = ResourcePools::Get().models;
+        while (!retired.empty()) {
+            GLenum status = glClientWaitSync(retired.front().fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+            glDeleteSync(retired.front().fence);
+            models.remove(retired.front().model);
+            retired.pop_front();
+            ++freed;
+        }
+    }
+
+    void EditorCommandQueue::shutdown() {
+        HandlePool<Model>& models = ResourcePools::Get().models;
+        for (const RetiredModel& entry : retired) {
+            glDeleteSync(entry.fence);
+            models.remove(entry.model);
+        }
+        retired.clear();
+    }
+
+    void EditorCommandQueue::loaderLoop() {
+        Profiler::setThreadName("Model Loader");
+        for (;;) {
+            std::string path;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return quit || loadRequested; });
+                if (quit) return;
+                path = std::move(loadPath);
+                loadRequested = false;
+            }
+            auto start = Clock::now();
+            std::unique_ptr<ModelImport> import = Model::Import(path, &cancelLoad);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished = std::move(import);
+                finishedMs = elapsedMs(start);
+                finishedReady = true;
+            }
+        }
+    }
+
+    void EditorCommandQueue::renderImGui() {
+        ImGui::Begin("Editor Commands");
+        if (loadInFlight) ImGui::Text("Importing %s", loadingPath.c_str());
+        else ImGui::TextDisabled("No import in flight");
+        if (hasPendingMesh) ImGui::Text("Next model: %s", pendingMesh.c_str());
+        if (hasPendingMusic) ImGui::Text("Next music: %s", pendingMusic.c_str());
+        ImGui::Text("Requests: %d  Coalesced: %d  Cancelled: %d  Loaded: %d", requests, coalesced, cancelled, installed);
+        ImGui::Text("Last import: %.1f ms (loader thread), GL upload: %.1f ms", lastImportMs, lastInstallMs);
+        ImGui::Text("Hot reloads: %d  Freed: %d  Waiting on GPU: %zu", reloads, freed, retired.size());
+        ImGui::End();
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "SceneManager.h"
+#include "HandlePool.h"
+
+namespace SS
+{
+    class Model;
+    class SoundManager;
+    struct ModelImport;
+
+    // Editor actions queued instead of run from the UI. A newer request for the
+    // model or the music supersedes the pending one, and a request only starts
+    // once no newer one arrived for kSettleMs, so a burst of selections loads
+    // the last one. Models are imported on a loader thread; a newer request
+    // cancels the import in flight and only the GL upload runs on the frame.
+    // A replaced model is kept until the GPU finished the frames drawing it.
+    class EditorCommandQueue {
+    public:
+        static constexpr double kSettleMs = 150.0;
+
+        EditorCommandQueue();
+        ~EditorCommandQueue();
+
+        EditorCommandQueue(const EditorCommandQueue&) = delete;
+        EditorCommandQueue& operator=(const EditorCommandQueue&) = delete;
+
+        void loadMesh(const std::string& path);
+        void playMusic(const std::string& path);
+        // Model and music as above; the lighting applies at the next process().
+        void loadScene(const Scene& scene);
+        // Imports `path` again if the current model was loaded from it, e.g.
+        // after the file was re-exported. A model the user picked meanwhile wins.
+        void reloadMesh(const std::string& path);
+
+        // Runs the commands that are due. A finished import becomes a new pooled
+        // model that replaces `model`; the old one is freed a few frames later,
+        // once the GPU finished with it. Call once per frame where the editor may
+        // change the scene (while no update is in flight).
+        void process(Handle<Model>& model, SoundManager& sound, std::string& currentMusic,
+            glm::vec3& lightPos, float& ambientIntensity, std::vector<PointLight>& pointLights);
+
+        bool loading() const { return loadInFlight; }
+
+        // Frees the replaced models still waiting on the GPU, must run while
+        // the GL context is alive.
+        void shutdown();
+
+        void renderImGui();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        // Latest request per target, owned by the editor thread
+        std::string pendingMesh;
+        std::string pendingMusic;
+        bool hasPendingMesh = false;
+        bool hasPendingMusic = false;
+        bool hasPendingLighting = false;
+        Clock::time_point meshRequested;
+        Clock::time_point musicRequested;
+        Scene pendingLighting;
+        std::vector<std::string> pendingReloads;
+
+        // Replaced models, oldest first, freed once their fence signalled
+        struct RetiredModel {
+            Handle<Model> model;
+            GLsync fence = nullptr;
+        };
+        std::deque<RetiredModel> retired;
+
+        // Loader thread, one import at a time
+        std::thread loader;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::string loadPath;
+        bool loadRequested = false;
+        bool quit = false;
+        std::atomic<bool> cancelLoad{ false };
+        std::unique_ptr<ModelImport> finished;
+        bool finishedReady = false;
+        double finishedMs = 0.0;
+
+        bool loadInFlight = false;
+        std::string loadingPath;
+
+        int requests = 0;
+        int coalesced = 0;
+        int cancelled = 0;
+        int installed = 0;
+        int reloads = 0;
+        int freed = 0;
+        double lastImportMs = 0.0;
+        double lastInstallMs = 0.0;
+
+        void startLoad(const std::string& path);
+        void retire(Handle<Model> model);
+        void freeRetired();
+        void loaderLoop();
+    };
+}
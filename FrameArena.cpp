@@ -0,0 +1,72 @@
+#include "FrameArena.h"
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace SS
+{
+    namespace
+    {
+        thread_local FrameArena* tlsArena = nullptr;
+
+        constexpr size_t kOverflowSlots = 64;
+
+        uintptr_t alignUp(uintptr_t value, size_t alignment) {
+            return (value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        }
+    }
+
+    FrameArena::FrameArena(size_t initialBytes)
+        : size(std::max<size_t>(initialBytes, 4096)) {
+        block = static_cast<unsigned char*>(::operator new(size));
+        overflow.reserve(kOverflowSlots);
+        MemoryTracker::allocated(MemoryTag::FrameArenas, size);
+    }
+
+    FrameArena::~FrameArena() {
+        for (void* p : overflow) ::operator delete(p);
+        ::operator delete(block);
+        MemoryTracker::freed(MemoryTag::FrameArenas, size + overflowBytes);
+        if (tlsArena == this) tlsArena = nullptr;
+    }
+
+    void* FrameArena::allocate(size_t bytes, size_t alignment) {
+        uintptr_t base = reinterpret_cast<uintptr_t>(block);
+        uintptr_t start = alignUp(base + used, alignment);
+        if (start + bytes <= base + size) {
+            used = static_cast<size_t>(start - base) + bytes;
+            peak = std::max(peak, bytesUsed());
+            return reinterpret_cast<void*>(start);
+        }
+        // Out of room: serve it from the heap for now and grow at the next reset
+        void* chunk = ::operator new(bytes + alignment);
+        overflow.push_back(chunk);
+        overflowBytes += bytes + alignment;
+        MemoryTracker::allocated(MemoryTag::FrameArenas, bytes + alignment);
+        peak = std::max(peak, bytesUsed());
+        return reinterpret_cast<void*>(alignUp(reinterpret_cast<uintptr_t>(chunk), alignment));
+    }
+
+    void FrameArena::reset() {
+        if (!overflow.empty()) {
+            for (void* p : overflow) ::operator delete(p);
+            overflow.clear();
+            size_t grown = std::max(size * 2, (used + overflowBytes) * 3 / 2);
+            ::operator delete(block);
+            MemoryTracker::freed(MemoryTag::FrameArenas, size + overflowBytes);
+            block = static_cast<unsigned char*>(::operator new(grown));
+            MemoryTracker::allocated(MemoryTag::FrameArenas, grown);
+            size = grown;
+            overflowBytes = 0;
+        }
+        used = 0;
+    }
+
+    FrameArena* FrameArena::current() {
+        return tlsArena;
+    }
+
+    void FrameArena::setCurrent(FrameArena* arena) {
+        tlsArena = arena;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace SS
+{
+    // Linear allocator for data that lives at most one frame. Allocating bumps a
+    // pointer and reset() at the start of the frame frees everything at once.
+    // A frame that outgrows the block chains overflow blocks, which the next
+    // reset() merges into one larger block, so a steady frame never touches the heap.
+    class FrameArena {
+    public:
+        explicit FrameArena(size_t initialBytes = 1 << 20);
+        ~FrameArena();
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+        void reset();
+
+        size_t bytesUsed() const { return used + overflowBytes; }
+        size_t capacity() const { return size; }
+        size_t peakBytes() const { return peak; }
+
+        // The arena of the calling thread's frame loop, nullptr outside of one.
+        static FrameArena* current();
+        static void setCurrent(FrameArena* arena);
+
+    private:
+        unsigned char* block = nullptr;
+        size_t size = 0;
+        size_t used = 0;
+        std::vector<void*> overflow; // reserved up front, released on reset
+        size_t overflowBytes = 0;
+        size_t peak = 0;
+    };
+
+    // STL allocator over a FrameArena. deallocate() is a no-op, memory comes back
+    // with the arena's reset. Without an arena it falls back to the heap.
+    template <typename T>
+    class ArenaAllocator {
+    public:
+        using value_type = T;
+
+        ArenaAllocator() noexcept : arena(FrameArena::current()) {}
+        explicit ArenaAllocator(FrameArena* arena) noexcept : arena(arena) {}
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+        T* allocate(size_t n) {
+            if (arena) return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        void deallocate(T* p, size_t) noexcept {
+            if (!arena) ::operator delete(p);
+        }
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena == other.arena; }
+        template <typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena != other.arena; }
+
+        FrameArena* arena;
+    };
+
+    template <typename T>
+    using FrameVector = std::vector<T, ArenaAllocator<T>>;
+}
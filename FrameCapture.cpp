@@ -0,0 +1,220 @@
+#include "FrameCapture.h"
+#include "Profiler.h"
+#include "MemoryTracker.h"
+#include "stb_image_write.h"
+#include <imgui.h>
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include <ctime>
+#include <cstdio>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+namespace SS
+{
+    namespace
+    {
+        std::string timestamp() {
+            std::time_t now = std::time(nullptr);
+            std::tm local{};
+#ifdef _WIN32
+            localtime_s(&local, &now);
+#else
+            localtime_r(&now, &local);
+#endif
+            char buf[32];
+            std::strftime(buf, sizeof(buf), "%Y%m%d_%H%M%S", &local);
+            return buf;
+        }
+    }
+
+    FrameCapture::FrameCapture() {
+        unsigned count = std::max(1u, std::min(2u, std::thread::hardware_concurrency() / 2));
+        for (unsigned i = 0; i < count; ++i) {
+            encoders.emplace_back(&FrameCapture::encoderLoop, this);
+        }
+    }
+
+    FrameCapture::~FrameCapture() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            quit = true;
+        }
+        queueReady.notify_all();
+        for (auto& t : encoders) {
+            t.join();
+        }
+    }
+
+    void FrameCapture::shutdown() {
+        for (auto& slot : slots) {
+            if (slot.fence) glDeleteSync(slot.fence);
+            if (slot.pbo) GpuMemory::deleteBuffers(1, &slot.pbo);
+            slot = Slot{};
+        }
+    }
+
+    void FrameCapture::requestScreenshot() {
+        screenshotPending = true;
+    }
+
+    void FrameCapture::setRecording(bool record) {
+        if (record && !recording) {
+            sequenceDirectory = (fs::path("captures") / ("sequence_" + timestamp())).string();
+            sequenceFrame = 0;
+        }
+        recording = record;
+    }
+
+    std::string FrameCapture::nextPath() {
+        std::error_code ec;
+        char name[32];
+        if (recording) {
+            fs::create_directories(sequenceDirectory, ec);
+            std::snprintf(name, sizeof(name), "frame_%06d.png", sequenceFrame++);
+            return (fs::path(sequenceDirectory) / name).string();
+        }
+        fs::create_directories("captures", ec);
+        std::snprintf(name, sizeof(name), "_%03d.png", screenshotIndex++);
+        return (fs::path("captures") / ("screenshot_" + timestamp() + name)).string();
+    }
+
+    void FrameCapture::captureFrame(GLuint framebuffer, int width, int height) {
+        if (!screenshotPending && !recording) return;
+        if (width <= 0 || height <= 0) return;
+
+        Slot& slot = slots[nextSlot];
+        if (slot.fence) {
+            // The oldest readback is still in flight, drop rather than wait on it
+            ++droppedGpu;
+            return;
+        }
+        screenshotPending = false;
+
+        size_t size = static_cast<size_t>(width) * height * 4;
+        if (!slot.pbo) glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        if (slot.capacity != size) {
+            GpuMemory::bufferData(slot.pbo, GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ, MemoryTag::GpuStreamBuffers);
+            slot.capacity = size;
+        }
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        if (framebuffer == 0) glReadBuffer(GL_BACK);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.width = width;
+        slot.height = height;
+        slot.path = nextPath();
+        nextSlot = (nextSlot + 1) % kRingSize;
+    }
+
+    void FrameCapture::poll() {
+        // Oldest slot first so images reach the encoders in capture order
+        for (int i = 0; i < kRingSize; ++i) {
+            Slot& slot = slots[(nextSlot + i) % kRingSize];
+            if (!slot.fence) continue;
+
+            GLenum status = glClientWaitSync(slot.fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+
+            EncodeJob job;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (encodeQueue.size() >= kMaxEncodeQueue) {
+                    ++droppedEncode;
+                    continue;
+                }
+                if (!freeBuffers.empty()) {
+                    job.pixels = std::move(freeBuffers.back());
+                    freeBuffers.pop_back();
+                }
+            }
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.capacity, GL_MAP_READ_BIT);
+            if (mapped) {
+                job.pixels.resize(slot.capacity);
+                std::memcpy(job.pixels.data(), mapped, slot.capacity);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            if (!mapped) continue;
+
+            job.width = slot.width;
+            job.height = slot.height;
+            job.path = std::move(slot.path);
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                encodeQueue.push_back(std::move(job));
+            }
+            queueReady.notify_one();
+        }
+    }
+
+    void FrameCapture::encoderLoop() {
+        Profiler::setThreadName("Capture Encoder");
+        std::vector<unsigned char> flipped;
+        for (;;) {
+            EncodeJob job;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [&] { return quit || !encodeQueue.empty(); });
+                if (encodeQueue.empty()) return; // only when quitting, after draining
+                job = std::move(encodeQueue.front());
+                encodeQueue.pop_front();
+            }
+
+            SS_PROFILE_SCOPE("Encode PNG");
+            // GL rows are bottom-up, PNG rows top-down
+            size_t stride = static_cast<size_t>(job.width) * 4;
+            flipped.resize(job.pixels.size());
+            for (int y = 0; y < job.height; ++y) {
+                std::memcpy(&flipped[y * stride], &job.pixels[(job.height - 1 - y) * stride], stride);
+            }
+            if (stbi_write_png(job.path.c_str(), job.width, job.height, 4, flipped.data(), static_cast<int>(stride))) {
+                ++framesWritten;
+            }
+            else {
+                ++encodeFailures;
+                std::cerr << "Failed to write capture: " << job.path << "\n";
+            }
+
+            std::lock_guard<std::mutex> lock(queueMutex);
+            freeBuffers.push_back(std::move(job.pixels));
+        }
+    }
+
+    void FrameCapture::renderImGui() {
+        ImGui::Begin("Capture");
+        if (ImGui::Button("Screenshot")) {
+            requestScreenshot();
+        }
+        ImGui::SameLine();
+        bool record = recording;
+        if (ImGui::Checkbox("Record Sequence", &record)) {
+            setRecording(record);
+        }
+
+        int inFlight = 0;
+        for (const auto& slot : slots) inFlight += slot.fence ? 1 : 0;
+        size_t queued = 0;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queued = encodeQueue.size();
+        }
+        ImGui::Text("Readbacks in flight: %d / %d", inFlight, kRingSize);
+        ImGui::Text("Encode queue: %zu / %zu (%zu threads)", queued, kMaxEncodeQueue, encoders.size());
+        ImGui::Text("Written: %d  Failed: %d", framesWritten.load(), encodeFailures.load());
+        ImGui::Text("Dropped: %d (GPU ring full), %d (encoder backlog)", droppedGpu, droppedEncode);
+        if (recording) ImGui::Text("Recording to %s", sequenceDirectory.c_str());
+        ImGui::End();
+    }
+}
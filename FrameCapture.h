@@ -0,0 +1,79 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <GL/glew.h>
+
+namespace SS
+{
+    // Screenshot and image sequence capture without pipeline stalls. Frames are read
+    // into a ring of pixel buffer objects guarded by fences, mapped a few frames
+    // later once the GPU is done, and PNG-encoded on background threads.
+    class FrameCapture {
+    public:
+        static constexpr int kRingSize = 4;
+        static constexpr size_t kMaxEncodeQueue = 16;
+
+        FrameCapture();
+        ~FrameCapture();
+
+        FrameCapture(const FrameCapture&) = delete;
+        FrameCapture& operator=(const FrameCapture&) = delete;
+
+        void requestScreenshot();
+        void setRecording(bool record);
+        bool isRecording() const { return recording; }
+
+        // Call once per frame with the framebuffer holding the finished image.
+        void captureFrame(GLuint framebuffer, int width, int height);
+        // Hands finished readbacks to the encoders; never waits on the GPU.
+        void poll();
+        void shutdown();
+
+        void renderImGui();
+
+    private:
+        struct Slot {
+            GLuint pbo = 0;
+            GLsync fence = nullptr;
+            size_t capacity = 0;
+            int width = 0;
+            int height = 0;
+            std::string path;
+        };
+
+        struct EncodeJob {
+            std::vector<unsigned char> pixels;
+            int width = 0;
+            int height = 0;
+            std::string path;
+        };
+
+        Slot slots[kRingSize];
+        int nextSlot = 0;
+        bool screenshotPending = false;
+        bool recording = false;
+        std::string sequenceDirectory;
+        int sequenceFrame = 0;
+        int screenshotIndex = 0;
+
+        std::vector<std::thread> encoders;
+        std::mutex queueMutex;
+        std::condition_variable queueReady;
+        std::deque<EncodeJob> encodeQueue;
+        std::vector<std::vector<unsigned char>> freeBuffers;
+        bool quit = false;
+
+        std::atomic<int> framesWritten{ 0 };
+        std::atomic<int> encodeFailures{ 0 };
+        int droppedGpu = 0;
+        int droppedEncode = 0;
+
+        void encoderLoop();
+        std::string nextPath();
+    };
+}
@@ -0,0 +1,140 @@
+#include "FramePacer.h"
+#include "FrameArena.h"
+#include <GLFW/glfw3.h>
+#include <imgui.h>
+#include <algorithm>
+#include <thread>
+
+namespace SS
+{
+    namespace
+    {
+        // Sleep granularity is coarse on most desktop schedulers, so the limiter
+        // sleeps until this margin before the deadline and spins the rest.
+        constexpr auto kSpinMargin = std::chrono::microseconds(2000);
+    }
+
+    FramePacer::FramePacer()
+        : history(kHistorySize, 0.0f)
+    {
+    }
+
+    void FramePacer::shutdown() {
+        for (GLsync fence : inFlight) {
+            glDeleteSync(fence);
+        }
+        inFlight.clear();
+    }
+
+    void FramePacer::init(GLFWwindow* window) {
+        (void)window;
+        adaptiveSupported = glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+            glfwExtensionSupported("GLX_EXT_swap_control_tear");
+        applyVsync();
+    }
+
+    void FramePacer::applyVsync() {
+        if (vsync == VSyncMode::Adaptive && !adaptiveSupported) {
+            vsync = VSyncMode::On;
+        }
+        switch (vsync) {
+        case VSyncMode::Off: glfwSwapInterval(0); break;
+        case VSyncMode::On: glfwSwapInterval(1); break;
+        case VSyncMode::Adaptive: glfwSwapInterval(-1); break;
+        }
+        appliedVsync = vsync;
+    }
+
+    void FramePacer::waitForDeadline() {
+        if (!limitFrameRate || targetFps <= 0) {
+            nextDeadline = Clock::now();
+            return;
+        }
+        auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+        nextDeadline += period;
+
+        auto now = Clock::now();
+        if (nextDeadline < now) {
+            // Fell behind, restart the schedule instead of bursting to catch up
+            nextDeadline = now;
+            return;
+        }
+        if (nextDeadline - now > kSpinMargin) {
+            std::this_thread::sleep_for(nextDeadline - now - kSpinMargin);
+        }
+        while (Clock::now() < nextDeadline) {
+            std::this_thread::yield();
+        }
+    }
+
+    void FramePacer::beginFrame() {
+        if (vsync != appliedVsync) {
+            applyVsync();
+        }
+        waitForDeadline();
+
+        auto now = Clock::now();
+        if (hasLastFrame) {
+            lastMs = std::chrono::duration<float, std::milli>(now - lastFrameStart).count();
+            history[historyHead] = lastMs;
+            historyHead = (historyHead + 1) % kHistorySize;
+            historyCount = std::min(historyCount + 1, kHistorySize);
+        }
+        lastFrameStart = now;
+        hasLastFrame = true;
+    }
+
+    void FramePacer::endFrame() {
+        inFlight.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        while (static_cast<int>(inFlight.size()) > std::max(1, maxFramesInFlight)) {
+            GLsync oldest = inFlight.front();
+            inFlight.pop_front();
+            glClientWaitSync(oldest, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // 100 ms
+            glDeleteSync(oldest);
+        }
+    }
+
+    float FramePacer::averageFrameMs() const {
+        if (historyCount == 0) return 0.0f;
+        float sum = 0.0f;
+        for (size_t i = 0; i < historyCount; ++i) sum += history[i];
+        return sum / historyCount;
+    }
+
+    void FramePacer::renderImGui() {
+        ImGui::Begin("Frame Pacing");
+
+        int mode = static_cast<int>(vsync);
+        const char* modes[] = { "Off", "On", "Adaptive" };
+        if (ImGui::Combo("VSync", &mode, modes, adaptiveSupported ? 3 : 2)) {
+            vsync = static_cast<VSyncMode>(mode);
+        }
+        ImGui::Checkbox("Limit Frame Rate", &limitFrameRate);
+        ImGui::SliderInt("Target FPS", &targetFps, 15, 360);
+        ImGui::SliderInt("Max Frames In Flight", &maxFramesInFlight, 1, 4);
+
+        if (historyCount > 0) {
+            FrameVector<float> sorted(history.begin(), history.begin() + historyCount);
+            std::sort(sorted.begin(), sorted.end());
+            float avg = averageFrameMs();
+            float p99 = sorted[std::min(historyCount - 1, historyCount * 99 / 100)];
+
+            // 1% low: mean FPS over the slowest 1% of frames
+            size_t worstCount = std::max<size_t>(1, historyCount / 100);
+            float worstSum = 0.0f;
+            for (size_t i = historyCount - worstCount; i < historyCount; ++i) worstSum += sorted[i];
+            float low1 = worstSum > 0.0f ? 1000.0f * worstCount / worstSum : 0.0f;
+
+            ImGui::Text("Average: %.2f ms (%.1f FPS)", avg, avg > 0.0f ? 1000.0f / avg : 0.0f);
+            ImGui::Text("1%% low: %.1f FPS", low1);
+            ImGui::Text("99th percentile: %.2f ms", p99);
+
+            // Plot oldest to newest; once the ring has wrapped the oldest sample is at the head
+            int offset = historyCount == kHistorySize ? static_cast<int>(historyHead) : 0;
+            ImGui::PlotLines("##FrameTimes", history.data(), static_cast<int>(historyCount), offset,
+                "frame time (ms)", 0.0f, std::max(33.3f, p99 * 1.2f), ImVec2(0, 80));
+        }
+
+        ImGui::End();
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <GL/glew.h>
+
+struct GLFWwindow;
+
+namespace SS
+{
+    enum class VSyncMode {
+        Off,
+        On,
+        Adaptive
+    };
+
+    // Owns swap interval, frame rate limiting, the frames-in-flight cap and the
+    // frame time history shown in the "Frame Pacing" panel.
+    class FramePacer {
+    public:
+        static constexpr size_t kHistorySize = 512;
+
+        VSyncMode vsync = VSyncMode::On;
+        bool limitFrameRate = false;
+        int targetFps = 60;
+        int maxFramesInFlight = 2;
+
+        FramePacer();
+
+        void init(GLFWwindow* window);
+        // Call at the top of the frame: applies vsync changes, waits for the
+        // limiter deadline and records the previous frame's duration.
+        void beginFrame();
+        // Call right after glfwSwapBuffers: fences the frame and blocks while
+        // more than `maxFramesInFlight` frames are still queued on the GPU.
+        void endFrame();
+        // Releases outstanding fences, must run while the GL context is alive.
+        void shutdown();
+
+        float lastFrameMs() const { return lastMs; }
+        float averageFrameMs() const;
+
+        void renderImGui();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        bool adaptiveSupported = false;
+        VSyncMode appliedVsync = VSyncMode::On;
+        bool hasLastFrame = false;
+        Clock::time_point lastFrameStart;
+        Clock::time_point nextDeadline;
+        float lastMs = 0.0f;
+
+        std::vector<float> history;
+        size_t historyHead = 0;
+        size_t historyCount = 0;
+
+        std::deque<GLsync> inFlight;
+
+        void applyVsync();
+        void waitForDeadline();
+    };
+}
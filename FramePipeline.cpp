@@ -0,0 +1,118 @@
+#include "FramePipeline.h"
+#include "Profiler.h"
+#include "Timing.h"
+#include <imgui.h>
+#include <algorithm>
+
+namespace SS
+{
+    FramePipeline::FramePipeline(UpdateFn updateFn)
+        : update(std::move(updateFn)) {
+        latencyMs.reserve(kLatencyHistory);
+        worker = std::thread(&FramePipeline::workerLoop, this);
+    }
+
+    FramePipeline::~FramePipeline() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    void FramePipeline::run(RenderSnapshot& snapshot) {
+        auto start = std::chrono::steady_clock::now();
+        update(snapshot);
+        snapshot.updateMs = elapsedMs(start);
+    }
+
+    void FramePipeline::workerLoop() {
+        Profiler::setThreadName("Update");
+        FrameArena::setCurrent(&arena);
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return quit || requested; });
+                if (quit) return;
+                requested = false;
+            }
+            {
+                SS_PROFILE_SCOPE("Update Frame");
+                arena.reset();
+                run(snapshots[1 - readIndex]);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                inFlight = false;
+            }
+            finished.notify_all();
+        }
+    }
+
+    void FramePipeline::waitForUpdate() {
+        SS_PROFILE_SCOPE("Wait For Update");
+        auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&] { return !inFlight; });
+        lastWaitMs = elapsedMs(start);
+        // readIndex only changes here, while the worker is idle
+        if (kicked) {
+            readIndex = 1 - readIndex;
+            kicked = false;
+        }
+    }
+
+    void FramePipeline::kick() {
+        RenderSnapshot& target = snapshots[1 - readIndex];
+        target.frame = nextFrame++;
+        target.inputTime = std::chrono::steady_clock::now();
+        if (!pipelined) {
+            SS_PROFILE_SCOPE("Update Frame");
+            run(target);
+            readIndex = 1 - readIndex;
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inFlight = true;
+            requested = true;
+            kicked = true;
+        }
+        wake.notify_one();
+    }
+
+    void FramePipeline::presented() {
+        const RenderSnapshot& shown = current();
+        if (shown.frame == 0) return;
+        float ms = static_cast<float>(elapsedMs(shown.inputTime));
+        if (latencyMs.size() < kLatencyHistory) {
+            latencyMs.push_back(ms);
+        }
+        else {
+            latencyMs[latencyHead] = ms;
+            latencyHead = (latencyHead + 1) % kLatencyHistory;
+        }
+    }
+
+    void FramePipeline::renderImGui() {
+        ImGui::Begin("Frame Pipeline");
+        ImGui::Checkbox("Pipelined Update", &pipelined);
+        ImGui::SameLine();
+        ImGui::TextDisabled(pipelined ? "(update N+1 overlaps render N)" : "(update, then render)");
+        const RenderSnapshot& shown = current();
+        ImGui::Text("Update: %.3f ms  Render waited: %.3f ms", shown.updateMs, lastWaitMs);
+        if (!latencyMs.empty()) {
+            float sum = 0.0f, worst = 0.0f;
+            for (float ms : latencyMs) {
+                sum += ms;
+                worst = std::max(worst, ms);
+            }
+            ImGui::Text("Input to present: %.2f ms avg, %.2f ms max", sum / latencyMs.size(), worst);
+            int offset = latencyMs.size() == kLatencyHistory ? static_cast<int>(latencyHead) : 0;
+            ImGui::PlotLines("##Latency", latencyMs.data(), static_cast<int>(latencyMs.size()), offset,
+                nullptr, 0.0f, worst * 1.2f, ImVec2(0.0f, 60.0f));
+        }
+        ImGui::End();
+    }
+}
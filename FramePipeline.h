@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Meshlet.h"
+#include "FrameArena.h"
+
+namespace SS
+{
+    // Everything the render stage needs from one update, so rendering never
+    // reads state the next update is writing.
+    struct RenderSnapshot {
+        uint64_t frame = 0;
+        std::chrono::steady_clock::time_point inputTime; // when the update's input was sampled
+        double updateMs = 0.0;
+
+        glm::mat4 view{ 1.0f };
+        glm::mat4 projection{ 1.0f };
+        glm::vec3 camPos{ 0.0f };
+        glm::vec3 lightPos{ 0.0f };
+        float ambientIntensity = 0.0f;
+
+        glm::mat4 modelMatrix{ 1.0f };
+        uint32_t modelRevision = 0; // the draws below only apply to this model
+        uint32_t poseRevision = 0;
+        std::vector<uint8_t> meshVisibility;
+        MeshletDrawList meshlets;
+
+        // Visible crowd instances, `crowdJoints` palette matrices per instance
+        size_t crowdJoints = 0;
+        std::vector<glm::mat4> crowdTransforms;
+        std::vector<glm::mat4> crowdPalettes;
+    };
+
+    // Two-stage frame loop. An update thread fills one of two snapshots while the
+    // render thread submits the other, so frame N+1 is simulated during frame N's
+    // GL work at the cost of one frame of latency. Between waitForUpdate() and
+    // kick() the update thread is idle and the render thread may change anything
+    // the update reads (UI, loading); outside that window it may only read.
+    class FramePipeline {
+    public:
+        using UpdateFn = std::function<void(RenderSnapshot& snapshot)>;
+
+        static constexpr size_t kLatencyHistory = 120;
+
+        // Off runs the update inline right before rendering its result.
+        bool pipelined = true;
+
+        explicit FramePipeline(UpdateFn update);
+        ~FramePipeline();
+
+        FramePipeline(const FramePipeline&) = delete;
+        FramePipeline& operator=(const FramePipeline&) = delete;
+
+        // Blocks until the update in flight, if any, has produced its snapshot.
+        void waitForUpdate();
+        // Starts the next update; inline when not pipelined.
+        void kick();
+        // Latest finished snapshot, unchanged until the next waitForUpdate().
+        const RenderSnapshot& current() const { return snapshots[readIndex]; }
+        // Call after the swap that showed `current()` to record its latency.
+        void presented();
+
+        void renderImGui();
+
+        // Scratch arena of the update thread, reset before each update.
+        const FrameArena& updateArena() const { return arena; }
+
+    private:
+        UpdateFn update;
+        FrameArena arena;
+        RenderSnapshot snapshots[2];
+        int readIndex = 0;
+        uint64_t nextFrame = 1;
+
+        std::thread worker;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable finished;
+        bool requested = false;
+        bool inFlight = false; // guarded by mutex while the worker runs
+        bool kicked = false;   // a finished update has not been picked up yet
+        bool quit = false;
+
+        double lastWaitMs = 0.0;
+        std::vector<float> latencyMs;
+        size_t latencyHead = 0;
+
+        void run(RenderSnapshot& snapshot);
+        void workerLoop();
+    };
+}
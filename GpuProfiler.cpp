@@ -0,0 +1,139 @@
+#include "GpuProfiler.h"
+#include <imgui.h>
+#include <cstring>
+
+namespace SS
+{
+    void GpuProfiler::init() {
+        for (auto& slot : ring) {
+            glGenQueries(kMaxScopes * 2, slot.queries);
+        }
+        initialized = true;
+    }
+
+    void GpuProfiler::shutdown() {
+        if (!initialized) return;
+        for (auto& slot : ring) {
+            glDeleteQueries(kMaxScopes * 2, slot.queries);
+            slot = FrameSlot{};
+        }
+        initialized = false;
+    }
+
+    int GpuProfiler::findPass(const char* name) const {
+        for (size_t i = 0; i < passes.size(); ++i) {
+            if (passes[i].name == name) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    void GpuProfiler::collect(FrameSlot& slot) {
+        if (!slot.pending) return;
+        // Only the query issued last needs checking, results arrive in issue order
+        GLint available = 0;
+        glGetQueryObjectiv(slot.lastIssued, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            ++lateFrames;
+            slot.pending = false;
+            return;
+        }
+
+        for (int i = 0; i < slot.scopeCount; ++i) {
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(slot.queries[i * 2], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(slot.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+            Pass& pass = passes[slot.scopes[i].pass];
+            pass.lastMs = static_cast<float>(end - begin) / 1.0e6f;
+            pass.samples[pass.sampleHead] = pass.lastMs;
+            pass.sampleHead = (pass.sampleHead + 1) % kAverageWindow;
+            if (pass.sampleCount < kAverageWindow) ++pass.sampleCount;
+
+            float sum = 0.0f;
+            for (int s = 0; s < pass.sampleCount; ++s) sum += pass.samples[s];
+            pass.average = sum / pass.sampleCount;
+            pass.sampledFrame = frameIndex;
+        }
+        slot.pending = false;
+    }
+
+    void GpuProfiler::beginFrame() {
+        if (!initialized) return;
+        FrameSlot& slot = ring[frameIndex % kLatency];
+        collect(slot); // issued kLatency frames ago
+        // Passes no longer measured drop their average, so callers fall back to CPU time
+        for (auto& pass : passes) {
+            if (pass.sampleCount > 0 && frameIndex - pass.sampledFrame > kLatency) {
+                pass.sampleCount = 0;
+                pass.sampleHead = 0;
+                pass.lastMs = 0.0f;
+                pass.average = 0.0f;
+            }
+        }
+        slot.scopeCount = 0;
+        slot.lastIssued = 0;
+        openDepth = 0;
+    }
+
+    void GpuProfiler::endFrame() {
+        if (!initialized) return;
+        FrameSlot& slot = ring[frameIndex % kLatency];
+        slot.pending = slot.scopeCount > 0 && slot.lastIssued != 0;
+        ++frameIndex;
+    }
+
+    int GpuProfiler::beginScope(const char* name) {
+        if (!initialized || !enabled) return -1;
+        FrameSlot& slot = ring[frameIndex % kLatency];
+        if (slot.scopeCount >= kMaxScopes) return -1;
+
+        int pass = findPass(name);
+        if (pass < 0) {
+            passes.push_back(Pass{});
+            passes.back().name = name;
+            pass = static_cast<int>(passes.size()) - 1;
+        }
+        passes[pass].depth = openDepth;
+
+        int scope = slot.scopeCount++;
+        slot.scopes[scope].pass = pass;
+        slot.scopes[scope].depth = openDepth++;
+        glQueryCounter(slot.queries[scope * 2], GL_TIMESTAMP);
+        return scope;
+    }
+
+    void GpuProfiler::endScope(int scope) {
+        if (scope < 0) return;
+        FrameSlot& slot = ring[frameIndex % kLatency];
+        glQueryCounter(slot.queries[scope * 2 + 1], GL_TIMESTAMP);
+        slot.lastIssued = slot.queries[scope * 2 + 1];
+        --openDepth;
+    }
+
+    float GpuProfiler::averageMs(const char* name) const {
+        int pass = findPass(name);
+        return enabled && pass >= 0 ? passes[pass].average : 0.0f;
+    }
+
+    void GpuProfiler::renderImGui() {
+        ImGui::Begin("GPU Timings");
+        ImGui::Checkbox("Enabled", &enabled);
+        ImGui::Text("Read back %d frames late, %d frames not ready", kLatency, lateFrames);
+        if (ImGui::BeginTable("##GpuPasses", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV)) {
+            ImGui::TableSetupColumn("Pass");
+            ImGui::TableSetupColumn("Avg (ms)");
+            ImGui::TableSetupColumn("Last (ms)");
+            ImGui::TableHeadersRow();
+            for (const auto& pass : passes) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%*s%s", pass.depth * 2, "", pass.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", pass.average);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", pass.lastMs);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+}
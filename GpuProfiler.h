@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+namespace SS
+{
+    // Per-pass GPU timings from GL_TIMESTAMP queries. Each frame's queries live in
+    // one slot of a ring and are read back kLatency frames later, so the CPU never
+    // waits for results. Timestamps (rather than GL_TIME_ELAPSED) let scopes nest.
+    class GpuProfiler {
+    public:
+        static constexpr int kLatency = 4;
+        static constexpr int kMaxScopes = 32;
+        static constexpr int kAverageWindow = 64;
+
+        bool enabled = true;
+
+        void init();
+        void shutdown();
+
+        void beginFrame();
+        void endFrame();
+
+        int beginScope(const char* name);
+        void endScope(int scope);
+
+        // Rolling average in milliseconds, 0 when the pass has no samples yet or
+        // was not measured within the last kLatency frames (e.g. while disabled).
+        float averageMs(const char* name) const;
+
+        void renderImGui();
+
+    private:
+        struct Scope {
+            int pass = -1;
+            int depth = 0;
+        };
+
+        struct FrameSlot {
+            GLuint queries[kMaxScopes * 2] = {};
+            Scope scopes[kMaxScopes];
+            int scopeCount = 0;
+            GLuint lastIssued = 0; // query written last, outer scopes end after inner ones
+            bool pending = false;
+        };
+
+        struct Pass {
+            std::string name;
+            int depth = 0;
+            float samples[kAverageWindow] = {};
+            int sampleCount = 0;
+            int sampleHead = 0;
+            float lastMs = 0.0f;
+            float average = 0.0f;
+            int sampledFrame = 0; // frameIndex when the last sample was read back
+        };
+
+        FrameSlot ring[kLatency];
+        int frameIndex = 0;
+        int openDepth = 0;
+        bool initialized = false;
+        int lateFrames = 0;
+        std::vector<Pass> passes;
+
+        int findPass(const char* name) const;
+        void collect(FrameSlot& slot);
+    };
+
+    class GpuTimerScope {
+    public:
+        GpuTimerScope(GpuProfiler& profiler, const char* name)
+            : profiler(profiler), scope(profiler.beginScope(name)) {}
+        ~GpuTimerScope() { profiler.endScope(scope); }
+
+        GpuTimerScope(const GpuTimerScope&) = delete;
+        GpuTimerScope& operator=(const GpuTimerScope&) = delete;
+
+    private:
+        GpuProfiler& profiler;
+        int scope;
+    };
+}
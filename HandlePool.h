@@ -0,0 +1,114 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+namespace SS
+{
+    // 32-bit reference into a HandlePool<T>: a slot index and the generation the
+    // slot had when the item was inserted. Zero is never issued, so a default
+    // handle is null.
+    template <typename T>
+    struct Handle {
+        uint32_t value = 0;
+
+        explicit operator bool() const { return value != 0; }
+        bool operator==(Handle other) const { return value == other.value; }
+        bool operator!=(Handle other) const { return value != other.value; }
+    };
+
+    // Items packed in one array for iteration, addressed through a slot table
+    // by generational handles. Lookup and validity checks are O(1); removing an
+    // item moves the last one into its place and bumps the slot's generation, so
+    // stale handles fail the check while every other handle stays valid.
+    // References from get() and iteration are invalidated by emplace and remove.
+    template <typename T>
+    class HandlePool {
+    public:
+        static constexpr uint32_t kIndexBits = 20;
+        static constexpr uint32_t kMaxItems = 1u << kIndexBits;
+        static constexpr uint32_t kGenerationLimit = 1u << (32 - kIndexBits);
+
+        // Returns a null handle when the pool is full.
+        template <typename... Args>
+        Handle<T> emplace(Args&&... args) {
+            uint32_t slot;
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            else {
+                if (slots.size() >= kMaxItems) return {};
+                slot = static_cast<uint32_t>(slots.size());
+                slots.push_back(Slot{});
+            }
+            slots[slot].item = static_cast<uint32_t>(items.size());
+            items.emplace_back(std::forward<Args>(args)...);
+            itemSlots.push_back(slot);
+            return Handle<T>{ (slots[slot].generation << kIndexBits) | slot };
+        }
+
+        bool remove(Handle<T> handle) {
+            if (!contains(handle)) return false;
+            uint32_t slot = handle.value & (kMaxItems - 1);
+            uint32_t item = slots[slot].item;
+            uint32_t last = static_cast<uint32_t>(items.size()) - 1;
+            if (item != last) {
+                items[item] = std::move(items[last]);
+                itemSlots[item] = itemSlots[last];
+                slots[itemSlots[item]].item = item;
+            }
+            items.pop_back();
+            itemSlots.pop_back();
+
+            Slot& freed = slots[slot];
+            freed.item = kNoItem;
+            freed.generation = freed.generation + 1 < kGenerationLimit ? freed.generation + 1 : 1;
+            freeSlots.push_back(slot);
+            return true;
+        }
+
+        bool contains(Handle<T> handle) const {
+            uint32_t slot = handle.value & (kMaxItems - 1);
+            return handle.value != 0 && slot < slots.size() && slots[slot].item != kNoItem
+                && slots[slot].generation == handle.value >> kIndexBits;
+        }
+
+        T* get(Handle<T> handle) { return contains(handle) ? &items[slots[handle.value & (kMaxItems - 1)].item] : nullptr; }
+        const T* get(Handle<T> handle) const {
+            return contains(handle) ? &items[slots[handle.value & (kMaxItems - 1)].item] : nullptr;
+        }
+
+        // Removes everything; outstanding handles all become stale.
+        void clear() {
+            while (!items.empty()) remove(handleAt(items.size() - 1));
+        }
+
+        size_t size() const { return items.size(); }
+        bool empty() const { return items.empty(); }
+
+        // Dense iteration, in no particular order
+        T* begin() { return items.data(); }
+        T* end() { return items.data() + items.size(); }
+        const T* begin() const { return items.data(); }
+        const T* end() const { return items.data() + items.size(); }
+        Handle<T> handleAt(size_t index) const {
+            uint32_t slot = itemSlots[index];
+            return Handle<T>{ (slots[slot].generation << kIndexBits) | slot };
+        }
+
+    private:
+        static constexpr uint32_t kNoItem = ~0u;
+
+        struct Slot {
+            uint32_t item = kNoItem;
+            uint32_t generation = 1;
+        };
+
+        std::vector<T> items;
+        std::vector<uint32_t> itemSlots; // slot of each item
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+    };
+}
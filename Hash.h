@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace SS
+{
+    constexpr uint64_t kFnv1aOffset = 1469598103934665603ull;
+
+    // 64-bit FNV-1a; pass the previous result as `hash` to continue it.
+    inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = kFnv1aOffset) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    inline uint64_t fnv1a(const std::string& s, uint64_t hash = kFnv1aOffset) {
+        return fnv1a(s.data(), s.size(), hash);
+    }
+}
@@ -0,0 +1,382 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Timing.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace SS
+{
+    namespace
+    {
+        // Spins before an idle worker goes to sleep, short enough to not burn a core
+        constexpr int kIdleSpins = 64;
+
+        // The system and deque owned by the calling thread, if any
+        thread_local JobSystem* tlsSystem = nullptr;
+        thread_local int tlsSlot = -1;
+        thread_local uint32_t tlsRandom = 0x9E3779B9u;
+
+        uint32_t nextRandom() {
+            tlsRandom ^= tlsRandom << 13;
+            tlsRandom ^= tlsRandom >> 17;
+            tlsRandom ^= tlsRandom << 5;
+            return tlsRandom;
+        }
+
+        struct TaskJob {
+            std::function<void()> task;
+        };
+
+        struct RangeBatch {
+            void (*fn)(void*, size_t, size_t) = nullptr;
+            void* context = nullptr;
+            size_t count = 0;
+            size_t grain = 1;
+            std::atomic<size_t> next{ 0 };
+        };
+
+        // Chunks are claimed from a shared cursor, so a few helper jobs balance
+        // the whole range and a parallelFor never allocates
+        void runRange(RangeBatch& batch) {
+            for (;;) {
+                size_t begin = batch.next.fetch_add(batch.grain);
+                if (begin >= batch.count) break;
+                size_t end = std::min(begin + batch.grain, batch.count);
+                batch.fn(batch.context, begin, end);
+            }
+        }
+    }
+
+    bool JobSystem::WorkDeque::push(Job* job) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= kCapacity) return false;
+        slots[b & (kCapacity - 1)].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    JobSystem::Job* JobSystem::WorkDeque::pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Job* job = slots[b & (kCapacity - 1)].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last job, race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    JobSystem::Job* JobSystem::WorkDeque::steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+        Job* job = slots[t & (kCapacity - 1)].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+        return job;
+    }
+
+    JobSystem::JobSystem(unsigned threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threadCount = std::min(threadCount, kMaxThreads);
+        for (unsigned i = 0; i < threadCount; ++i) {
+            deques.push_back(std::make_unique<WorkDeque>());
+        }
+        previousSystem = tlsSystem;
+        previousSlot = tlsSlot;
+        tlsSystem = this;
+        tlsSlot = 0;
+        for (unsigned i = 1; i < threadCount; ++i) {
+            workers.emplace_back(&JobSystem::workerLoop, this, static_cast<int>(i));
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        quit.store(true);
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_all();
+        for (auto& t : workers) {
+            t.join();
+        }
+        if (tlsSystem == this) {
+            tlsSystem = previousSystem;
+            tlsSlot = previousSlot;
+        }
+    }
+
+    JobSystem& JobSystem::Get() {
+        static JobSystem system;
+        return system;
+    }
+
+    int JobSystem::currentSlot() const {
+        return tlsSystem == this ? tlsSlot : -1;
+    }
+
+    void JobSystem::submit(Job* job) {
+        if (job->counter) job->counter->pending.fetch_add(1, std::memory_order_relaxed);
+        int slot = currentSlot();
+        if (slot >= 0) {
+            if (!deques[slot]->push(job)) {
+                // Deque full: running it here keeps the caller making progress
+                execute(*job);
+                return;
+            }
+        }
+        else {
+            std::lock_guard<std::mutex> lock(injectMutex);
+            injected.push_back(job);
+        }
+        queued.fetch_add(1);
+        if (sleeping.load() > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wake.notify_one();
+        }
+    }
+
+    JobSystem::Job* JobSystem::findJob(int slot) {
+        Job* job = slot >= 0 ? deques[slot]->pop() : nullptr;
+        if (!job && queued.load(std::memory_order_relaxed) > 0) {
+            {
+                std::lock_guard<std::mutex> lock(injectMutex);
+                if (!injected.empty()) {
+                    job = injected.front();
+                    injected.pop_front();
+                }
+            }
+            if (!job) {
+                // Steal from a random victim first so thieves spread out
+                size_t count = deques.size();
+                size_t start = nextRandom() % count;
+                for (size_t i = 0; i < count && !job; ++i) {
+                    size_t victim = (start + i) % count;
+                    if (static_cast<int>(victim) == slot) continue;
+                    job = deques[victim]->steal();
+                }
+                if (job) steals.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (job) queued.fetch_sub(1);
+        return job;
+    }
+
+    JobSystem::Job* JobSystem::takeBackground(const JobCounter* owner) {
+        if (backgroundQueued.load(std::memory_order_relaxed) == 0) return nullptr;
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        auto it = owner ? std::find_if(background.begin(), background.end(),
+            [owner](const Job* job) { return job->counter == owner; }) : background.begin();
+        if (it == background.end()) return nullptr;
+        Job* job = *it;
+        background.erase(it);
+        backgroundQueued.fetch_sub(1);
+        return job;
+    }
+
+    void JobSystem::execute(Job& job) {
+        SS_PROFILE_SCOPE("Job");
+        // The job may free itself, keep what is needed afterwards
+        JobCounter* counter = job.counter;
+        if (job.owned) {
+            TaskJob* task = static_cast<TaskJob*>(job.data);
+            task->task();
+            delete task;
+            delete &job;
+        }
+        else {
+            job.entry(job);
+        }
+        jobsRun.fetch_add(1, std::memory_order_relaxed);
+        if (counter) counter->pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    void JobSystem::workerLoop(int slot) {
+        Profiler::setThreadName("Worker");
+        tlsSystem = this;
+        tlsSlot = slot;
+        tlsRandom = 0x9E3779B9u * static_cast<uint32_t>(slot + 1);
+        int idle = 0;
+        while (!quit.load(std::memory_order_relaxed)) {
+            Job* job = findJob(slot);
+            if (!job) job = takeBackground(nullptr);
+            if (job) {
+                execute(*job);
+                idle = 0;
+                continue;
+            }
+            if (++idle < kIdleSpins) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleeping.fetch_add(1);
+            wake.wait(lock, [&] { return quit.load() || queued.load() > 0 || backgroundQueued.load() > 0; });
+            sleeping.fetch_sub(1);
+            idle = 0;
+        }
+    }
+
+    void JobSystem::run(std::function<void()> task, JobCounter* counter) {
+        Job* job = new Job;
+        job->data = new TaskJob{ std::move(task) };
+        job->counter = counter;
+        job->owned = true;
+        submit(job);
+    }
+
+    void JobSystem::runBackground(std::function<void()> task, JobCounter* counter) {
+        Job* job = new Job;
+        job->data = new TaskJob{ std::move(task) };
+        job->counter = counter;
+        job->owned = true;
+        if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(backgroundMutex);
+            background.push_back(job);
+        }
+        backgroundQueued.fetch_add(1);
+        if (sleeping.load() > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wake.notify_one();
+        }
+    }
+
+    void JobSystem::wait(JobCounter& counter) {
+        SS_PROFILE_SCOPE("JobSystem::wait");
+        int slot = currentSlot();
+        while (!counter.done()) {
+            Job* job = findJob(slot);
+            // Background jobs of other counters are left to the workers
+            if (!job) job = takeBackground(&counter);
+            if (job) {
+                execute(*job);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::parallelForImpl(size_t count, size_t grain, RangeFn fn, void* context) {
+        if (count == 0) return;
+        grain = std::max<size_t>(1, grain);
+        size_t chunks = (count + grain - 1) / grain;
+        if (deques.size() == 1 || chunks == 1) {
+            fn(context, 0, count);
+            return;
+        }
+
+        RangeBatch batch;
+        batch.fn = fn;
+        batch.context = context;
+        batch.count = count;
+        batch.grain = grain;
+        JobCounter counter;
+        Job helpers[kMaxThreads];
+        size_t helperCount = std::min(chunks, deques.size()) - 1;
+        for (size_t i = 0; i < helperCount; ++i) {
+            helpers[i].entry = [](Job& job) { runRange(*static_cast<RangeBatch*>(job.data)); };
+            helpers[i].data = &batch;
+            helpers[i].counter = &counter;
+            submit(&helpers[i]);
+        }
+        runRange(batch);
+        wait(counter);
+    }
+
+    std::vector<JobBenchmarkResult> JobSystem::runBenchmark() {
+        SS_PROFILE_SCOPE("JobSystem Benchmark");
+        constexpr size_t kElements = 1 << 20;
+        constexpr int kSmallJobs = 20000;
+        constexpr int kRepeats = 10;
+        std::vector<float> data(kElements);
+        std::vector<JobBenchmarkResult> results;
+
+        unsigned maxThreads = std::min(kMaxThreads, std::max(1u, std::thread::hardware_concurrency()));
+        for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+            JobSystem jobs(threads);
+            JobBenchmarkResult result;
+            result.threads = threads;
+
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < kRepeats; ++r) {
+                jobs.parallelFor(kElements, 4096, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        float x = static_cast<float>(i + r);
+                        data[i] = std::sqrt(x) * std::sin(x) + std::cos(x * 0.5f);
+                    }
+                });
+            }
+            result.parallelForMs = elapsedMs(start) / kRepeats;
+
+            std::atomic<uint64_t> sum{ 0 };
+            start = std::chrono::steady_clock::now();
+            for (int r = 0; r < kRepeats; ++r) {
+                JobCounter counter;
+                for (int i = 0; i < kSmallJobs; ++i) {
+                    jobs.run([&sum, i] { sum.fetch_add(static_cast<uint64_t>(i) * i, std::memory_order_relaxed); }, &counter);
+                }
+                jobs.wait(counter);
+            }
+            result.smallJobsMs = elapsedMs(start) / kRepeats;
+
+            results.push_back(result);
+            std::cout << "Job benchmark: " << threads << " thread(s): parallelFor " << result.parallelForMs << " ms, "
+                << kSmallJobs << " jobs " << result.smallJobsMs << " ms\n";
+            if (threads == maxThreads) break;
+        }
+        return results;
+    }
+
+    void JobSystem::renderImGui() {
+        ImGui::Begin("Jobs");
+        ImGui::Text("Threads: %u (%zu workers + main)", threadCount(), workers.size());
+        ImGui::Text("Jobs run: %llu  Steals: %llu", static_cast<unsigned long long>(jobsRun.load()),
+            static_cast<unsigned long long>(steals.load()));
+        ImGui::Text("Background queued: %d", backgroundQueued.load());
+
+        ImGui::Separator();
+        if (ImGui::Button("Run Scaling Benchmark")) {
+            benchmarkResults = runBenchmark();
+        }
+        if (!benchmarkResults.empty() && ImGui::BeginTable("JobBenchmark", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Threads");
+            ImGui::TableSetupColumn("parallelFor ms");
+            ImGui::TableSetupColumn("Speedup");
+            ImGui::TableSetupColumn("20k jobs ms");
+            ImGui::TableSetupColumn("Speedup##jobs");
+            ImGui::TableHeadersRow();
+            const JobBenchmarkResult& base = benchmarkResults[0];
+            for (const auto& result : benchmarkResults) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", result.threads);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", result.parallelForMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2fx", base.parallelForMs / std::max(result.parallelForMs, 1e-6));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", result.smallJobsMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2fx", base.smallJobsMs / std::max(result.smallJobsMs, 1e-6));
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace SS
+{
+    class JobSystem;
+
+    // Counts unfinished jobs. Jobs started with a counter increment it on submit
+    // and decrement it when they return; JobSystem::wait() blocks until zero.
+    class JobCounter {
+    public:
+        bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+        std::atomic<int> pending{ 0 };
+    };
+
+    struct JobBenchmarkResult {
+        unsigned threads = 0;
+        double parallelForMs = 0.0; // fine grained range over a large array
+        double smallJobsMs = 0.0;   // many independent tiny jobs
+    };
+
+    // Work-stealing job system. Every worker, plus the thread that created the
+    // system, owns a lock-free deque: it pushes and pops at the bottom while idle
+    // threads steal from the top. Other threads submit through a locked queue.
+    // Waiting never blocks a thread that could run jobs, so jobs may submit and
+    // wait on further jobs (nested parallelFor is fine).
+    // Background jobs (asset imports) sit in a separate queue that idle workers
+    // drain after the regular jobs. wait() only runs the background jobs of the
+    // counter it waits on, so a frame's parallelFor never picks up a long import.
+    class JobSystem {
+    public:
+        static constexpr unsigned kMaxThreads = 64;
+
+        // `threadCount` includes the creating thread, 0 uses every hardware thread.
+        explicit JobSystem(unsigned threadCount = 0);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        // Queues `task`. With a counter, wait(*counter) returns after it ran.
+        void run(std::function<void()> task, JobCounter* counter = nullptr);
+        // Like run(), at low priority.
+        void runBackground(std::function<void()> task, JobCounter* counter = nullptr);
+        // Runs other jobs on the calling thread until `counter` reaches zero.
+        void wait(JobCounter& counter);
+
+        // Splits [0, count) into chunks of at most `grain` items, runs them on all
+        // threads including the caller and returns once every chunk has finished.
+        // `fn(begin, end)` is called through a plain pointer, so no std::function
+        // is built and the call never touches the heap.
+        template <typename Fn>
+        void parallelFor(size_t count, size_t grain, Fn&& fn) {
+            parallelForImpl(count, grain, [](void* context, size_t begin, size_t end) {
+                (*static_cast<std::remove_reference_t<Fn>*>(context))(begin, end);
+            }, const_cast<void*>(static_cast<const void*>(&fn)));
+        }
+
+        unsigned threadCount() const { return static_cast<unsigned>(deques.size()); }
+
+        static JobSystem& Get();
+
+        // Times a fixed workload on systems of 1, 2, 4 ... hardware threads.
+        static std::vector<JobBenchmarkResult> runBenchmark();
+        void renderImGui();
+
+    private:
+        struct Job {
+            void (*entry)(Job& job) = nullptr;
+            void* data = nullptr;
+            JobCounter* counter = nullptr;
+            bool owned = false; // allocated by run(), freed after it executes
+        };
+
+        // Chase-Lev deque of job pointers with a fixed capacity
+        struct alignas(64) WorkDeque {
+            static constexpr int64_t kCapacity = 4096;
+            std::atomic<int64_t> top{ 0 };
+            std::atomic<int64_t> bottom{ 0 };
+            std::unique_ptr<std::atomic<Job*>[]> slots{ new std::atomic<Job*>[kCapacity] };
+
+            bool push(Job* job);
+            Job* pop();
+            Job* steal();
+        };
+
+        std::vector<std::unique_ptr<WorkDeque>> deques; // [0] belongs to the creating thread
+        std::vector<std::thread> workers;
+        std::mutex injectMutex;
+        std::deque<Job*> injected; // from threads without a deque
+        std::atomic<int> queued{ 0 };
+        std::mutex backgroundMutex;
+        std::deque<Job*> background;
+        std::atomic<int> backgroundQueued{ 0 };
+        std::atomic<int> sleeping{ 0 };
+        std::atomic<bool> quit{ false };
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+
+        std::atomic<uint64_t> jobsRun{ 0 };
+        std::atomic<uint64_t> steals{ 0 };
+        std::vector<JobBenchmarkResult> benchmarkResults;
+
+        // Thread-local binding of the creating thread, restored on destruction
+        JobSystem* previousSystem = nullptr;
+        int previousSlot = -1;
+
+        using RangeFn = void (*)(void* context, size_t begin, size_t end);
+        void parallelForImpl(size_t count, size_t grain, RangeFn fn, void* context);
+
+        int currentSlot() const;
+        void submit(Job* job);
+        Job* findJob(int slot);
+        // Oldest background job, or with `owner` the oldest one counted by it
+        Job* takeBackground(const JobCounter* owner);
+        void execute(Job& job);
+        void workerLoop(int slot);
+    };
+}
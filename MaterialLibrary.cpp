@@ -0,0 +1,277 @@
+#include "MaterialLibrary.h"
+#include "Profiler.h"
+#include <imgui.h>
+#include <algorithm>
+#include <iostream>
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize2.h"
+
+namespace SS
+{
+    namespace
+    {
+        // Layers of the smallest class on first use, halved per larger class
+        constexpr int kInitialLayers = 8;
+
+        int mipLevels(int size) {
+            int levels = 1;
+            while (size > 1) {
+                size >>= 1;
+                ++levels;
+            }
+            return levels;
+        }
+
+        int sizeClassFor(int width, int height) {
+            int largest = std::max(width, height);
+            int sizeClass = 0;
+            while (sizeClass < MaterialLibrary::kSizeClasses - 1 && MaterialLibrary::layerSize(sizeClass) < largest) {
+                ++sizeClass;
+            }
+            return sizeClass;
+        }
+
+        // RGBA8 with a full mip chain
+        double layerMegabytes(int size) {
+            return size * size * 4 * (4.0 / 3.0) / (1024.0 * 1024.0);
+        }
+    }
+
+    MaterialLibrary& MaterialLibrary::Get() {
+        static MaterialLibrary library;
+        return library;
+    }
+
+    void MaterialLibrary::init() {
+        table.assign(kMaxMaterials, MaterialData{});
+        slotUsed.assign(kMaxMaterials, 0);
+        slotUsed[kDefaultMaterial] = 1;
+
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        GpuMemory::bufferData(ubo, GL_UNIFORM_BUFFER, table.size() * sizeof(MaterialData), table.data(), GL_DYNAMIC_DRAW,
+            MemoryTag::GpuStreamBuffers);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        glGenFramebuffers(2, copyFramebuffers);
+    }
+
+    void MaterialLibrary::shutdown() {
+        if (ubo) GpuMemory::deleteBuffers(1, &ubo);
+        for (auto& array : arrays) {
+            if (array.texture) GpuMemory::deleteTextures(1, &array.texture);
+            array = LayerArray{};
+        }
+        if (copyFramebuffers[0]) glDeleteFramebuffers(2, copyFramebuffers);
+        ubo = 0;
+        copyFramebuffers[0] = copyFramebuffers[1] = 0;
+    }
+
+    bool MaterialLibrary::growLayers(int sizeClass, int capacity) {
+        LayerArray& array = arrays[sizeClass];
+        GLint maxLayers = 256;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        capacity = std::min(capacity, static_cast<int>(maxLayers));
+        if (capacity <= array.capacity) return false;
+
+        int layerPixels = layerSize(sizeClass);
+        GLuint grown = 0;
+        glGenTextures(1, &grown);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, grown);
+        int levels = mipLevels(layerPixels);
+        for (int level = 0, size = layerPixels; level < levels; ++level, size = std::max(size / 2, 1)) {
+            GpuMemory::texImage3D(grown, GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, size, size, capacity, GL_RGBA, GL_UNSIGNED_BYTE,
+                nullptr, MemoryTag::GpuMaterialTextures);
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        // GL 3.3 has no image copy, so existing layers move over with a blit each
+        if (array.texture) {
+            GLint previousFramebuffer = 0;
+            glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, copyFramebuffers[0]);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, copyFramebuffers[1]);
+            for (int layer = 0; layer < array.capacity; ++layer) {
+                if (!array.used[layer]) continue;
+                glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, array.texture, 0, layer);
+                glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, grown, 0, layer);
+                glBlitFramebuffer(0, 0, layerPixels, layerPixels, 0, 0, layerPixels, layerPixels, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+            GpuMemory::deleteTextures(1, &array.texture);
+            array.mipmapsDirty = true;
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        array.texture = grown;
+        array.capacity = capacity;
+        array.used.resize(capacity, 0);
+        return true;
+    }
+
+    bool MaterialLibrary::prepareTexture(const unsigned char* pixels, int width, int height, int channels,
+        ImageBuffer& rgba) {
+        SS_PROFILE_SCOPE("MaterialLibrary::prepareTexture");
+        if (!pixels || width <= 0 || height <= 0 || channels < 1 || channels > 4) return false;
+
+        // Expand to RGBA, then resample to the layer size of its class
+        std::vector<unsigned char> expanded;
+        const unsigned char* source = pixels;
+        if (channels != 4) {
+            expanded.resize(static_cast<size_t>(width) * height * 4);
+            for (size_t i = 0, n = static_cast<size_t>(width) * height; i < n; ++i) {
+                const unsigned char* src = pixels + i * channels;
+                unsigned char* dst = &expanded[i * 4];
+                dst[0] = src[0];
+                dst[1] = channels >= 3 ? src[1] : src[0];
+                dst[2] = channels >= 3 ? src[2] : src[0];
+                dst[3] = channels == 2 ? src[1] : 255;
+            }
+            source = expanded.data();
+        }
+        int size = layerSize(sizeClassFor(width, height));
+        rgba.resize(static_cast<size_t>(size) * size * 4);
+        if (width != size || height != size) {
+            stbir_resize_uint8_linear(source, width, height, 0, rgba.data(), size, size, 0, STBIR_RGBA);
+        }
+        else {
+            std::copy(source, source + rgba.size(), rgba.begin());
+        }
+        return true;
+    }
+
+    int MaterialLibrary::addTexture(const unsigned char* pixels, int width, int height, int channels) {
+        if (!prepareTexture(pixels, width, height, channels, prepared)) return -1;
+        return addPreparedTexture(prepared);
+    }
+
+    int MaterialLibrary::addPreparedTexture(const ImageBuffer& rgba) {
+        SS_PROFILE_SCOPE("MaterialLibrary::addPreparedTexture");
+        if (!ubo) return -1;
+        int sizeClass = 0;
+        while (sizeClass < kSizeClasses && rgba.size() != static_cast<size_t>(layerSize(sizeClass)) * layerSize(sizeClass) * 4) {
+            ++sizeClass;
+        }
+        if (sizeClass == kSizeClasses) return -1;
+
+        LayerArray& array = arrays[sizeClass];
+        auto freeLayer = std::find(array.used.begin(), array.used.end(), 0);
+        if (freeLayer == array.used.end()) {
+            int capacity = array.capacity ? array.capacity * 2 : std::max(1, kInitialLayers >> sizeClass);
+            if (!growLayers(sizeClass, capacity)) {
+                std::cerr << "Material texture array " << layerSize(sizeClass) << " is full (" << array.capacity
+                    << " layers)\n";
+                return -1;
+            }
+            freeLayer = std::find(array.used.begin(), array.used.end(), 0);
+        }
+        int layer = static_cast<int>(freeLayer - array.used.begin());
+
+        int size = layerSize(sizeClass);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        array.used[layer] = 1;
+        array.mipmapsDirty = true;
+        return layer * kSizeClasses + sizeClass;
+    }
+
+    void MaterialLibrary::releaseTexture(int texture) {
+        if (texture < 0) return;
+        LayerArray& array = arrays[sizeClassOf(texture)];
+        int layer = layerOf(texture);
+        if (layer < static_cast<int>(array.used.size())) array.used[layer] = 0;
+    }
+
+    int MaterialLibrary::addMaterial(const MaterialData& material) {
+        auto freeSlot = std::find(slotUsed.begin(), slotUsed.end(), 0);
+        if (freeSlot == slotUsed.end()) {
+            std::cerr << "Material table is full (" << kMaxMaterials << " entries)\n";
+            return kDefaultMaterial;
+        }
+        int slot = static_cast<int>(freeSlot - slotUsed.begin());
+        slotUsed[slot] = 1;
+        table[slot] = material;
+        if (ubo) {
+            glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+            glBufferSubData(GL_UNIFORM_BUFFER, slot * sizeof(MaterialData), sizeof(MaterialData), &table[slot]);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+        return slot;
+    }
+
+    void MaterialLibrary::releaseMaterial(int slot) {
+        if (slot != kDefaultMaterial && slot >= 0 && slot < static_cast<int>(slotUsed.size())) slotUsed[slot] = 0;
+    }
+
+    void MaterialLibrary::bind() {
+        if (!ubo) return;
+        glBindBufferBase(GL_UNIFORM_BUFFER, kBindingPoint, ubo);
+        for (int sizeClass = 0; sizeClass < kSizeClasses; ++sizeClass) {
+            LayerArray& array = arrays[sizeClass];
+            glActiveTexture(GL_TEXTURE0 + kTextureUnit + sizeClass);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+            // Mip chains are rebuilt once after a batch of uploads, not per texture
+            if (array.mipmapsDirty) {
+                glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+                array.mipmapsDirty = false;
+            }
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void MaterialLibrary::renderImGui() {
+        ImGui::Begin("Materials");
+        int materials = static_cast<int>(std::count(slotUsed.begin(), slotUsed.end(), 1));
+        ImGui::Text("Materials: %d / %d", materials, kMaxMaterials);
+        double totalMb = 0.0;
+        for (int sizeClass = 0; sizeClass < kSizeClasses; ++sizeClass) {
+            const LayerArray& array = arrays[sizeClass];
+            if (!array.capacity) continue;
+            int size = layerSize(sizeClass);
+            int layers = static_cast<int>(std::count(array.used.begin(), array.used.end(), 1));
+            double allocatedMb = array.capacity * layerMegabytes(size);
+            totalMb += allocatedMb;
+            ImGui::Text("%4dx%-4d layers: %d / %d (%.1f MB allocated)", size, size, layers, array.capacity, allocatedMb);
+        }
+        ImGui::Text("Texture arrays: %.1f MB (GPU Material Textures in the Memory panel)", totalMb);
+        if (ImGui::BeginTable("MaterialTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+            ImVec2(0.0f, 200.0f))) {
+            ImGui::TableSetupColumn("Slot");
+            ImGui::TableSetupColumn("Base Color");
+            ImGui::TableSetupColumn("Layer");
+            ImGui::TableSetupColumn("Metal / Rough");
+            ImGui::TableSetupColumn("Flags");
+            ImGui::TableHeadersRow();
+            for (int slot = 0; slot < static_cast<int>(table.size()); ++slot) {
+                if (!slotUsed[slot]) continue;
+                const MaterialData& m = table[slot];
+                ImGui::PushID(slot);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", slot);
+                ImGui::TableNextColumn();
+                ImGui::ColorButton("##base", ImVec4(m.baseColorFactor.r, m.baseColorFactor.g, m.baseColorFactor.b, m.baseColorFactor.a));
+                ImGui::TableNextColumn();
+                if (m.textureLayer >= 0) {
+                    int size = layerSize(sizeClassOf(m.textureLayer));
+                    ImGui::Text("%d (%dpx)", layerOf(m.textureLayer), size);
+                }
+                else {
+                    ImGui::TextUnformatted("-");
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f / %.2f", m.metallic, m.roughness);
+                ImGui::TableNextColumn();
+                ImGui::Text("0x%x", m.flags);
+                ImGui::PopID();
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "MemoryTracker.h"
+
+namespace SS
+{
+    enum MaterialFlags : int32_t {
+        MaterialHasBaseColorTexture = 1 << 0,
+        MaterialDoubleSided = 1 << 1
+    };
+
+    // RGBA pixels decoded on the CPU, waiting for upload
+    using ImageBuffer = TrackedVector<unsigned char, MemoryTag::DecodedImages>;
+
+    // One row of the material table, laid out as the shader's std140 Material struct.
+    struct MaterialData {
+        glm::vec4 baseColorFactor{ 1.0f };
+        float metallic = 1.0f;
+        float roughness = 1.0f;
+        int32_t textureLayer = -1;
+        int32_t flags = 0;
+    };
+    static_assert(sizeof(MaterialData) == 32, "MaterialData must match the std140 Material struct");
+
+    // Materials of every loaded model in one uniform buffer, and their base color
+    // textures as layers of texture arrays, one array per size class. All are
+    // bound once per frame, so a draw only selects its row with the materialIndex
+    // uniform and switching materials (or models) changes no GL state.
+    class MaterialLibrary {
+    public:
+        static constexpr int kMaxMaterials = 256;
+        // Class c holds kMinLayerSize << c square layers. A texture goes to the
+        // smallest class covering its larger side, so it is never shrunk below
+        // kMaxLayerSize and small textures do not pay for 1024^2 layers.
+        static constexpr int kSizeClasses = 5;
+        static constexpr int kMinLayerSize = 128;
+        static constexpr int kMaxLayerSize = kMinLayerSize << (kSizeClasses - 1);
+        static constexpr GLuint kBindingPoint = 1;
+        // Size class c binds to kTextureUnit + c
+        static constexpr GLuint kTextureUnit = 5;
+        // Row 0 is a plain white material for meshes without one
+        static constexpr int kDefaultMaterial = 0;
+
+        static MaterialLibrary& Get();
+
+        void init();
+        void shutdown();
+
+        // Resamples 8-bit pixels to their size class and stores them in a free
+        // layer. Returns the texture index for MaterialData::textureLayer, or -1
+        // when the class's texture array cannot grow.
+        int addTexture(const unsigned char* pixels, int width, int height, int channels);
+        // The CPU half of addTexture: expands to RGBA and resamples into `rgba`.
+        // Touches no GL or library state, so imports run it on worker threads.
+        static bool prepareTexture(const unsigned char* pixels, int width, int height, int channels,
+            ImageBuffer& rgba);
+        // Uploads RGBA pixels from prepareTexture; the size class follows from their size.
+        int addPreparedTexture(const ImageBuffer& rgba);
+        void releaseTexture(int texture);
+
+        // Texture indices interleave the classes: texture = layer * kSizeClasses + class
+        static int sizeClassOf(int texture) { return texture % kSizeClasses; }
+        static int layerOf(int texture) { return texture / kSizeClasses; }
+        static int layerSize(int sizeClass) { return kMinLayerSize << sizeClass; }
+
+        // Returns the table row, or kDefaultMaterial when the table is full.
+        int addMaterial(const MaterialData& material);
+        void releaseMaterial(int slot);
+
+        // Binds the table to kBindingPoint and the texture arrays from kTextureUnit on.
+        void bind();
+
+        void renderImGui();
+
+    private:
+        // Allocated on the first texture of its class
+        struct LayerArray {
+            GLuint texture = 0;
+            int capacity = 0;
+            std::vector<uint8_t> used;
+            bool mipmapsDirty = false;
+        };
+
+        GLuint ubo = 0;
+        GLuint copyFramebuffers[2] = { 0, 0 };
+        LayerArray arrays[kSizeClasses];
+
+        std::vector<MaterialData> table;
+        std::vector<uint8_t> slotUsed;
+        ImageBuffer prepared;
+
+        bool growLayers(int sizeClass, int capacity);
+    };
+}
@@ -0,0 +1,261 @@
+#include "MemoryTracker.h"
+#include <imgui.h>
+#include <nlohmann/json.hpp>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+
+using json = nlohmann::json;
+
+namespace SS
+{
+    namespace
+    {
+        struct TagCounters {
+            std::atomic<int64_t> current{ 0 };
+            std::atomic<int64_t> peak{ 0 };
+            std::atomic<int64_t> highWater{ 0 };
+            std::atomic<uint64_t> allocations{ 0 };
+        };
+        TagCounters counters[MemoryTracker::kTagCount];
+
+        const char* const kTagNames[MemoryTracker::kTagCount] = {
+            "glTF Document", "Decoded Images", "Vertices", "Scene Library", "Audio", "Frame Arenas",
+            "GPU Mesh Buffers", "GPU Stream Buffers", "GPU Textures", "GPU Material Textures", "GPU Render Targets"
+        };
+
+        void raise(std::atomic<int64_t>& value, int64_t candidate) {
+            int64_t seen = value.load(std::memory_order_relaxed);
+            while (candidate > seen && !value.compare_exchange_weak(seen, candidate, std::memory_order_relaxed)) {}
+        }
+
+        // GL object sizes by name; touched only on the context thread
+        struct GpuEntry {
+            MemoryTag tag = MemoryTag::GpuMeshBuffers;
+            int64_t bytes = 0;
+        };
+        constexpr int kMaxTextureLevels = 16;
+        struct GpuTextureEntry {
+            MemoryTag tag = MemoryTag::GpuTextures;
+            int64_t levels[kMaxTextureLevels] = {};
+        };
+        std::unordered_map<GLuint, GpuEntry> gpuBuffers;
+        std::unordered_map<GLuint, GpuEntry> gpuRenderbuffers;
+        std::unordered_map<GLuint, GpuTextureEntry> gpuTextures;
+
+        void replaceEntry(std::unordered_map<GLuint, GpuEntry>& entries, GLuint name, int64_t bytes, MemoryTag tag) {
+            GpuEntry& entry = entries[name];
+            if (entry.bytes > 0) MemoryTracker::freed(entry.tag, static_cast<size_t>(entry.bytes));
+            entry.tag = tag;
+            entry.bytes = bytes;
+            if (bytes > 0) MemoryTracker::allocated(tag, static_cast<size_t>(bytes));
+        }
+
+        void dropEntries(std::unordered_map<GLuint, GpuEntry>& entries, GLsizei count, const GLuint* names) {
+            for (GLsizei i = 0; i < count; ++i) {
+                auto it = entries.find(names[i]);
+                if (it == entries.end()) continue;
+                if (it->second.bytes > 0) MemoryTracker::freed(it->second.tag, static_cast<size_t>(it->second.bytes));
+                entries.erase(it);
+            }
+        }
+
+        // Approximate storage per texel; drivers pad 3-channel formats to 4 bytes
+        int64_t bytesPerTexel(GLint internalFormat) {
+            switch (internalFormat) {
+            case GL_R8: return 1;
+            case GL_RG8: case GL_R16F: return 2;
+            case GL_RGBA16F: case GL_RG32F: case GL_DEPTH32F_STENCIL8: return 8;
+            case GL_RGBA32F: return 16;
+            default: return 4; // RGBA8, RGB8, DEPTH_COMPONENT24, DEPTH24_STENCIL8, R32F
+            }
+        }
+
+        void trackTextureLevel(GLuint texture, GLint level, int64_t bytes, MemoryTag tag) {
+            if (level < 0 || level >= kMaxTextureLevels) return;
+            GpuTextureEntry& entry = gpuTextures[texture];
+            int64_t& stored = entry.levels[level];
+            if (stored > 0) MemoryTracker::freed(entry.tag, static_cast<size_t>(stored));
+            entry.tag = tag;
+            stored = bytes;
+            if (bytes > 0) MemoryTracker::allocated(tag, static_cast<size_t>(bytes));
+        }
+
+        char snapshotPath[256] = "memory_snapshot.json";
+
+        void formatBytes(char* buf, size_t size, int64_t bytes) {
+            double value = static_cast<double>(bytes);
+            if (value >= 1024.0 * 1024.0) std::snprintf(buf, size, "%.2f MB", value / (1024.0 * 1024.0));
+            else if (value >= 1024.0) std::snprintf(buf, size, "%.1f KB", value / 1024.0);
+            else std::snprintf(buf, size, "%lld B", static_cast<long long>(bytes));
+        }
+    }
+
+    void MemoryTracker::allocated(MemoryTag tag, size_t bytes) {
+        TagCounters& c = counters[static_cast<size_t>(tag)];
+        int64_t now = c.current.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) + static_cast<int64_t>(bytes);
+        c.allocations.fetch_add(1, std::memory_order_relaxed);
+        raise(c.peak, now);
+        raise(c.highWater, now);
+    }
+
+    void MemoryTracker::freed(MemoryTag tag, size_t bytes) {
+        counters[static_cast<size_t>(tag)].current.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    }
+
+    MemoryTagStats MemoryTracker::stats(MemoryTag tag) {
+        const TagCounters& c = counters[static_cast<size_t>(tag)];
+        MemoryTagStats result;
+        result.current = c.current.load(std::memory_order_relaxed);
+        result.peak = c.peak.load(std::memory_order_relaxed);
+        result.highWater = c.highWater.load(std::memory_order_relaxed);
+        result.allocations = c.allocations.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    const char* MemoryTracker::name(MemoryTag tag) {
+        return kTagNames[static_cast<size_t>(tag)];
+    }
+
+    void MemoryTracker::resetPeaks() {
+        for (auto& c : counters) c.peak.store(c.current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    bool MemoryTracker::exportSnapshot(const std::string& path) {
+        std::ofstream ofs(path);
+        if (!ofs.is_open()) {
+            std::cerr << "Failed to open file for writing: " << path << "\n";
+            return false;
+        }
+        json tags = json::array();
+        for (size_t i = 0; i < kTagCount; ++i) {
+            MemoryTag tag = static_cast<MemoryTag>(i);
+            MemoryTagStats s = stats(tag);
+            tags.push_back({
+                { "tag", name(tag) },
+                { "gpu", isGpu(tag) },
+                { "current", s.current },
+                { "peak", s.peak },
+                { "highWater", s.highWater },
+                { "allocations", s.allocations }
+                });
+        }
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        ofs << json{ { "timestamp", seconds }, { "tags", tags } }.dump(4);
+        return ofs.good();
+    }
+
+    void MemoryTracker::renderImGui() {
+        ImGui::Begin("Memory");
+        if (ImGui::Button("Reset Peaks")) resetPeaks();
+        ImGui::SameLine();
+        if (ImGui::Button("Export Snapshot")) {
+            if (exportSnapshot(snapshotPath)) std::cout << "Memory snapshot written to " << snapshotPath << "\n";
+        }
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(-1.0f);
+        ImGui::InputText("##SnapshotPath", snapshotPath, sizeof(snapshotPath));
+
+        if (ImGui::BeginTable("##MemoryTags", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV)) {
+            ImGui::TableSetupColumn("Tag");
+            ImGui::TableSetupColumn("Current");
+            ImGui::TableSetupColumn("Peak");
+            ImGui::TableSetupColumn("High Water");
+            ImGui::TableSetupColumn("Allocations");
+            ImGui::TableHeadersRow();
+            int64_t totals[2] = { 0, 0 };
+            char buf[32];
+            for (size_t i = 0; i < kTagCount; ++i) {
+                MemoryTag tag = static_cast<MemoryTag>(i);
+                MemoryTagStats s = stats(tag);
+                totals[isGpu(tag) ? 1 : 0] += s.current;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(name(tag));
+                ImGui::TableNextColumn();
+                formatBytes(buf, sizeof(buf), s.current);
+                ImGui::TextUnformatted(buf);
+                ImGui::TableNextColumn();
+                formatBytes(buf, sizeof(buf), s.peak);
+                ImGui::TextUnformatted(buf);
+                ImGui::TableNextColumn();
+                formatBytes(buf, sizeof(buf), s.highWater);
+                ImGui::TextUnformatted(buf);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(s.allocations));
+            }
+            ImGui::EndTable();
+            char gpu[32];
+            formatBytes(buf, sizeof(buf), totals[0]);
+            formatBytes(gpu, sizeof(gpu), totals[1]);
+            ImGui::Text("Tracked total: %s CPU, %s GPU", buf, gpu);
+        }
+        ImGui::End();
+    }
+
+    MemoryCharge& MemoryCharge::operator=(MemoryCharge&& other) noexcept {
+        if (this != &other) {
+            reset();
+            tag = other.tag;
+            charged = other.charged;
+            other.charged = 0;
+        }
+        return *this;
+    }
+
+    void MemoryCharge::set(MemoryTag newTag, size_t bytes) {
+        if (charged) MemoryTracker::freed(tag, charged);
+        tag = newTag;
+        charged = bytes;
+        if (charged) MemoryTracker::allocated(tag, charged);
+    }
+
+    void GpuMemory::bufferData(GLuint buffer, GLenum target, GLsizeiptr size, const void* data, GLenum usage, MemoryTag tag) {
+        glBufferData(target, size, data, usage);
+        replaceEntry(gpuBuffers, buffer, static_cast<int64_t>(size), tag);
+    }
+
+    void GpuMemory::deleteBuffers(GLsizei count, const GLuint* buffers) {
+        dropEntries(gpuBuffers, count, buffers);
+        glDeleteBuffers(count, buffers);
+    }
+
+    void GpuMemory::texImage2D(GLuint texture, GLenum target, GLint level, GLint internalFormat, GLsizei width,
+        GLsizei height, GLenum format, GLenum type, const void* pixels, MemoryTag tag) {
+        glTexImage2D(target, level, internalFormat, width, height, 0, format, type, pixels);
+        trackTextureLevel(texture, level, bytesPerTexel(internalFormat) * width * height, tag);
+    }
+
+    void GpuMemory::texImage3D(GLuint texture, GLenum target, GLint level, GLint internalFormat, GLsizei width,
+        GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels, MemoryTag tag) {
+        glTexImage3D(target, level, internalFormat, width, height, depth, 0, format, type, pixels);
+        trackTextureLevel(texture, level, bytesPerTexel(internalFormat) * width * height * depth, tag);
+    }
+
+    void GpuMemory::deleteTextures(GLsizei count, const GLuint* textures) {
+        for (GLsizei i = 0; i < count; ++i) {
+            auto it = gpuTextures.find(textures[i]);
+            if (it == gpuTextures.end()) continue;
+            for (int64_t bytes : it->second.levels) {
+                if (bytes > 0) MemoryTracker::freed(it->second.tag, static_cast<size_t>(bytes));
+            }
+            gpuTextures.erase(it);
+        }
+        glDeleteTextures(count, textures);
+    }
+
+    void GpuMemory::renderbufferStorage(GLuint renderbuffer, GLenum internalFormat, GLsizei width, GLsizei height,
+        MemoryTag tag) {
+        glRenderbufferStorage(GL_RENDERBUFFER, internalFormat, width, height);
+        replaceEntry(gpuRenderbuffers, renderbuffer, bytesPerTexel(internalFormat) * width * height, tag);
+    }
+
+    void GpuMemory::deleteRenderbuffers(GLsizei count, const GLuint* renderbuffers) {
+        dropEntries(gpuRenderbuffers, count, renderbuffers);
+        glDeleteRenderbuffers(count, renderbuffers);
+    }
+}
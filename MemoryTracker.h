@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <new>
+#include <GL/glew.h>
+
+namespace SS
+{
+    // Subsystems memory is accounted to. CPU tags are fed by tagged containers,
+    // charges and allocator hooks; GPU tags by the GpuMemory wrappers below.
+    enum class MemoryTag : uint8_t {
+        GltfDocument,  // tinygltf DOM: buffers, accessors, nodes
+        DecodedImages, // glTF images decoded by stb and their resampled RGBA copies
+        Vertices,      // SS::Vertex arrays of imports and CPU skinning
+        SceneLibrary,  // scenes.json contents held by SceneManager
+        Audio,         // everything miniaudio allocates, decoded PCM included
+        FrameArenas,
+        GpuMeshBuffers,
+        GpuStreamBuffers, // uniform, texture and pixel buffers rewritten at runtime
+        GpuTextures,
+        GpuMaterialTextures, // MaterialLibrary's layer arrays, full mip chains included
+        GpuRenderTargets,
+        Count
+    };
+
+    struct MemoryTagStats {
+        int64_t current = 0;
+        int64_t peak = 0;      // since the last resetPeaks()
+        int64_t highWater = 0; // since startup
+        uint64_t allocations = 0;
+    };
+
+    // Per-tag byte counters, lock-free and safe from any thread.
+    class MemoryTracker {
+    public:
+        static constexpr size_t kTagCount = static_cast<size_t>(MemoryTag::Count);
+
+        static void allocated(MemoryTag tag, size_t bytes);
+        static void freed(MemoryTag tag, size_t bytes);
+
+        static MemoryTagStats stats(MemoryTag tag);
+        static const char* name(MemoryTag tag);
+        static bool isGpu(MemoryTag tag) { return tag >= MemoryTag::GpuMeshBuffers; }
+        static void resetPeaks();
+
+        // Writes every tag's numbers as JSON.
+        static bool exportSnapshot(const std::string& path);
+        static void renderImGui();
+    };
+
+    // Bytes held by memory the tracker cannot hook (third-party containers).
+    // Moves with its owner and releases the charge when destroyed.
+    class MemoryCharge {
+    public:
+        MemoryCharge() = default;
+        MemoryCharge(MemoryTag tag, size_t bytes) { set(tag, bytes); }
+        ~MemoryCharge() { reset(); }
+
+        MemoryCharge(MemoryCharge&& other) noexcept : tag(other.tag), charged(other.charged) { other.charged = 0; }
+        MemoryCharge& operator=(MemoryCharge&& other) noexcept;
+        MemoryCharge(const MemoryCharge&) = delete;
+        MemoryCharge& operator=(const MemoryCharge&) = delete;
+
+        void set(MemoryTag tag, size_t bytes);
+        void reset() { set(tag, 0); }
+        size_t bytes() const { return charged; }
+
+    private:
+        MemoryTag tag = MemoryTag::GltfDocument;
+        size_t charged = 0;
+    };
+
+    // STL allocator that accounts its storage to `Tag`.
+    template <typename T, MemoryTag Tag>
+    class TrackingAllocator {
+    public:
+        using value_type = T;
+        template <typename U>
+        struct rebind { using other = TrackingAllocator<U, Tag>; };
+
+        TrackingAllocator() noexcept = default;
+        template <typename U>
+        TrackingAllocator(const TrackingAllocator<U, Tag>&) noexcept {}
+
+        T* allocate(size_t n) {
+            T* p = static_cast<T*>(::operator new(n * sizeof(T)));
+            MemoryTracker::allocated(Tag, n * sizeof(T));
+            return p;
+        }
+        void deallocate(T* p, size_t n) noexcept {
+            MemoryTracker::freed(Tag, n * sizeof(T));
+            ::operator delete(p);
+        }
+
+        template <typename U>
+        bool operator==(const TrackingAllocator<U, Tag>&) const noexcept { return true; }
+        template <typename U>
+        bool operator!=(const TrackingAllocator<U, Tag>&) const noexcept { return false; }
+    };
+
+    template <typename T, MemoryTag Tag>
+    using TrackedVector = std::vector<T, TrackingAllocator<T, Tag>>;
+
+    // GL allocation calls that also account the object's storage. Sizes are
+    // kept per object name, so respecifying or deleting an object replaces or
+    // drops its old size. Context thread only.
+    class GpuMemory {
+    public:
+        static void bufferData(GLuint buffer, GLenum target, GLsizeiptr size, const void* data, GLenum usage, MemoryTag tag);
+        static void deleteBuffers(GLsizei count, const GLuint* buffers);
+
+        static void texImage2D(GLuint texture, GLenum target, GLint level, GLint internalFormat, GLsizei width,
+            GLsizei height, GLenum format, GLenum type, const void* pixels, MemoryTag tag);
+        static void texImage3D(GLuint texture, GLenum target, GLint level, GLint internalFormat, GLsizei width,
+            GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels, MemoryTag tag);
+        static void deleteTextures(GLsizei count, const GLuint* textures);
+
+        static void renderbufferStorage(GLuint renderbuffer, GLenum internalFormat, GLsizei width, GLsizei height,
+            MemoryTag tag);
+        static void deleteRenderbuffers(GLsizei count, const GLuint* renderbuffers);
+    };
+}
@@ -0,0 +1,253 @@
+#include "Meshlet.h"
+#include "ModelManager.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Timing.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace SS
+{
+    namespace
+    {
+        constexpr size_t kMeshletsPerJob = 64;
+
+        enum MeshletResult : uint8_t {
+            MeshletVisible = 0,
+            MeshletOutsideFrustum = 1,
+            MeshletBackfacing = 2
+        };
+
+        void computeBounds(const std::vector<glm::vec3>& positions, const unsigned int* tri, size_t indexCount,
+            bool doubleSided, Meshlet& meshlet) {
+            glm::vec3 lo = positions[tri[0]], hi = lo;
+            for (size_t i = 1; i < indexCount; ++i) {
+                lo = glm::min(lo, positions[tri[i]]);
+                hi = glm::max(hi, positions[tri[i]]);
+            }
+            meshlet.center = (lo + hi) * 0.5f;
+            float radiusSq = 0.0f;
+            for (size_t i = 0; i < indexCount; ++i) {
+                glm::vec3 d = positions[tri[i]] - meshlet.center;
+                radiusSq = std::max(radiusSq, glm::dot(d, d));
+            }
+            meshlet.radius = std::sqrt(radiusSq);
+
+            // Cone around the average face normal; a spread of 90 degrees or more
+            // (or a double sided material) leaves cone culling disabled
+            meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+            meshlet.coneCutoff = 1.0f;
+            if (doubleSided) return;
+            std::vector<glm::vec3> normals;
+            normals.reserve(indexCount / 3);
+            glm::vec3 sum(0.0f);
+            for (size_t i = 0; i + 2 < indexCount; i += 3) {
+                glm::vec3 n = glm::cross(positions[tri[i + 1]] - positions[tri[i]], positions[tri[i + 2]] - positions[tri[i]]);
+                float length = glm::length(n);
+                if (length <= 0.0f) continue;
+                normals.push_back(n / length);
+                sum += normals.back();
+            }
+            float sumLength = glm::length(sum);
+            if (normals.empty() || sumLength <= 0.0f) return;
+            glm::vec3 axis = sum / sumLength;
+            float minDot = 1.0f;
+            for (const auto& n : normals) minDot = std::min(minDot, glm::dot(axis, n));
+            if (minDot <= 0.0f) return;
+            meshlet.coneAxis = axis;
+            meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+    }
+
+    void BuildMeshlets(const std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices,
+        bool doubleSided, std::vector<Meshlet>& meshlets) {
+        const size_t triCount = indices.size() / 3;
+        const size_t vertexCount = positions.size();
+        if (triCount == 0) return;
+
+        // Vertex -> triangle adjacency in CSR form
+        std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+        for (size_t i = 0; i < triCount * 3; ++i) ++adjacencyStart[indices[i] + 1];
+        for (size_t v = 0; v < vertexCount; ++v) adjacencyStart[v + 1] += adjacencyStart[v];
+        std::vector<uint32_t> adjacency(triCount * 3);
+        std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (size_t t = 0; t < triCount; ++t) {
+            for (int k = 0; k < 3; ++k) adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+        }
+
+        std::vector<uint8_t> emitted(triCount, 0);
+        std::vector<uint32_t> vertexTag(vertexCount, UINT32_MAX);
+        std::vector<uint32_t> candidates;
+        std::vector<unsigned int> reordered;
+        reordered.reserve(indices.size());
+        size_t scan = 0;
+        uint32_t meshletId = 0;
+
+        while (reordered.size() < indices.size()) {
+            Meshlet meshlet;
+            meshlet.firstIndex = static_cast<uint32_t>(reordered.size());
+            size_t uniqueVertices = 0;
+            size_t triangles = 0;
+            candidates.clear();
+
+            auto newVertices = [&](size_t t) {
+                int count = 0;
+                for (int k = 0; k < 3; ++k) count += vertexTag[indices[t * 3 + k]] != meshletId;
+                return count;
+            };
+            auto add = [&](size_t t) {
+                for (int k = 0; k < 3; ++k) {
+                    unsigned int v = indices[t * 3 + k];
+                    reordered.push_back(v);
+                    if (vertexTag[v] == meshletId) continue;
+                    vertexTag[v] = meshletId;
+                    ++uniqueVertices;
+                    candidates.insert(candidates.end(), adjacency.begin() + adjacencyStart[v], adjacency.begin() + adjacencyStart[v + 1]);
+                }
+                emitted[t] = 1;
+                ++triangles;
+            };
+
+            while (scan < triCount && emitted[scan]) ++scan;
+            add(scan);
+
+            while (triangles < kMeshletMaxTriangles) {
+                // Prefer the neighbour that brings the fewest new vertices
+                size_t best = SIZE_MAX;
+                int bestNew = 4;
+                for (uint32_t t : candidates) {
+                    if (emitted[t]) continue;
+                    int added = newVertices(t);
+                    if (added < bestNew && uniqueVertices + added <= kMeshletMaxVertices) {
+                        best = t;
+                        bestNew = added;
+                        if (added == 0) break;
+                    }
+                }
+                if (best == SIZE_MAX) {
+                    // Disconnected surface: keep filling small meshlets from the scan order
+                    if (uniqueVertices * 2 >= kMeshletMaxVertices || uniqueVertices + 3 > kMeshletMaxVertices) break;
+                    while (scan < triCount && emitted[scan]) ++scan;
+                    if (scan >= triCount) break;
+                    best = scan;
+                }
+                add(best);
+                // Drop consumed candidates now and then so the list stays short
+                if (candidates.size() > 1024) {
+                    candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                        [&](uint32_t t) { return emitted[t] != 0; }), candidates.end());
+                }
+            }
+
+            meshlet.indexCount = static_cast<uint32_t>(reordered.size()) - meshlet.firstIndex;
+            computeBounds(positions, &reordered[meshlet.firstIndex], meshlet.indexCount, doubleSided, meshlet);
+            meshlets.push_back(meshlet);
+            ++meshletId;
+        }
+        indices.swap(reordered);
+    }
+
+    void MeshletCuller::cull(const Model& model, const glm::mat4& modelMatrix, const glm::mat4& viewProj,
+        const glm::vec3& cameraPos, JobSystem& jobs) {
+        SS_PROFILE_SCOPE("Meshlet Culling");
+        auto start = std::chrono::steady_clock::now();
+        const auto& meshlets = model.GetMeshlets();
+        frameStats = {};
+        frameStats.meshlets = static_cast<int>(meshlets.size());
+
+        // Cull in model space: frustum planes of the full MVP (normalized, so
+        // distances are in model units) and the camera moved into the model's frame
+        glm::mat4 mvp = viewProj * modelMatrix;
+        glm::vec4 planes[6];
+        for (int i = 0; i < 3; ++i) {
+            glm::vec4 row(mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i]);
+            glm::vec4 w(mvp[0][3], mvp[1][3], mvp[2][3], mvp[3][3]);
+            planes[i * 2] = w + row;
+            planes[i * 2 + 1] = w - row;
+        }
+        for (auto& p : planes) p /= glm::length(glm::vec3(p));
+        glm::vec3 eye = glm::vec3(glm::inverse(modelMatrix) * glm::vec4(cameraPos, 1.0f));
+        const bool cones = coneCulling;
+
+        visible.resize(meshlets.size());
+        if (enabled) {
+            jobs.parallelFor(meshlets.size(), kMeshletsPerJob, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const Meshlet& m = meshlets[i];
+                    uint8_t result = MeshletVisible;
+                    for (const auto& p : planes) {
+                        if (glm::dot(glm::vec3(p), m.center) + p.w < -m.radius) {
+                            result = MeshletOutsideFrustum;
+                            break;
+                        }
+                    }
+                    if (result == MeshletVisible && cones && m.coneCutoff < 1.0f) {
+                        glm::vec3 toCenter = m.center - eye;
+                        if (glm::dot(toCenter, m.coneAxis) >= m.coneCutoff * glm::length(toCenter) + m.radius) {
+                            result = MeshletBackfacing;
+                        }
+                    }
+                    visible[i] = result;
+                }
+            });
+        }
+        else {
+            std::fill(visible.begin(), visible.end(), static_cast<uint8_t>(MeshletVisible));
+        }
+
+        // Compact survivors into per-mesh multi-draw ranges
+        list.counts.clear();
+        list.offsets.clear();
+        size_t meshCount = model.GetMeshCount();
+        list.meshFirst.assign(meshCount, 0);
+        list.meshCount.assign(meshCount, 0);
+        list.meshCulled.assign(meshCount, 0);
+        for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex) {
+            const MeshGL& mesh = model.GetMesh(meshIndex);
+            list.meshFirst[meshIndex] = static_cast<uint32_t>(list.counts.size());
+            uint32_t runStart = 0, runEnd = 0;
+            bool inRun = false;
+            for (uint32_t i = mesh.meshletOffset; i < mesh.meshletOffset + mesh.meshletCount; ++i) {
+                const Meshlet& m = meshlets[i];
+                frameStats.trianglesTotal += m.indexCount / 3;
+                if (visible[i] == MeshletOutsideFrustum) ++frameStats.frustumCulled;
+                if (visible[i] == MeshletBackfacing) ++frameStats.backfaceCulled;
+                if (visible[i] != MeshletVisible) continue;
+                frameStats.trianglesSubmitted += m.indexCount / 3;
+                if (inRun && m.firstIndex == runEnd) {
+                    runEnd += m.indexCount;
+                    continue;
+                }
+                if (inRun) {
+                    list.counts.push_back(static_cast<GLsizei>(runEnd - runStart));
+                    list.offsets.push_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(runStart) * sizeof(unsigned int)));
+                }
+                runStart = m.firstIndex;
+                runEnd = m.firstIndex + m.indexCount;
+                inRun = true;
+            }
+            if (inRun) {
+                list.counts.push_back(static_cast<GLsizei>(runEnd - runStart));
+                list.offsets.push_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(runStart) * sizeof(unsigned int)));
+            }
+            list.meshCount[meshIndex] = static_cast<uint32_t>(list.counts.size()) - list.meshFirst[meshIndex];
+            list.meshCulled[meshIndex] = mesh.meshletCount > 0 && list.meshCount[meshIndex] == 0;
+        }
+        frameStats.drawRanges = static_cast<int>(list.counts.size());
+        frameStats.cullMs = elapsedMs(start);
+    }
+
+    void MeshletCuller::renderImGui() {
+        ImGui::Begin("Meshlets");
+        ImGui::Checkbox("Cull Meshlets", &enabled);
+        ImGui::SameLine();
+        ImGui::Checkbox("Normal Cones", &coneCulling);
+        ImGui::Text("Meshlets: %d (max %zu vertices, %zu triangles)", frameStats.meshlets, kMeshletMaxVertices, kMeshletMaxTriangles);
+        ImGui::Text("Outside frustum: %d  Back-facing: %d", frameStats.frustumCulled, frameStats.backfaceCulled);
+        ImGui::Text("Triangles: %zu / %zu in %d draw ranges", frameStats.trianglesSubmitted, frameStats.trianglesTotal, frameStats.drawRanges);
+        ImGui::Text("Cull time: %.3f ms", frameStats.cullMs);
+        ImGui::End();
+    }
+}
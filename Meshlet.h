@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+namespace SS
+{
+    class Model;
+    class JobSystem;
+
+    constexpr size_t kMeshletMaxVertices = 64;
+    constexpr size_t kMeshletMaxTriangles = 124;
+
+    // A small cluster of triangles stored contiguously in its mesh's index buffer.
+    struct Meshlet {
+        uint32_t firstIndex = 0; // into the mesh's index buffer
+        uint32_t indexCount = 0;
+        glm::vec3 center{ 0.0f };
+        float radius = 0.0f;
+        glm::vec3 coneAxis{ 0.0f, 0.0f, 1.0f };
+        // Sine of the normals' spread around the axis; 1 disables cone culling
+        float coneCutoff = 1.0f;
+    };
+
+    // Splits a triangle list into meshlets, growing each one through shared
+    // vertices so clusters stay spatially compact. `indices` is reordered in
+    // place so every meshlet's triangles are contiguous.
+    void BuildMeshlets(const std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices,
+        bool doubleSided, std::vector<Meshlet>& meshlets);
+
+    struct MeshletStats {
+        int meshlets = 0;
+        int frustumCulled = 0;
+        int backfaceCulled = 0;
+        int drawRanges = 0;
+        size_t trianglesSubmitted = 0;
+        size_t trianglesTotal = 0;
+        double cullMs = 0.0;
+    };
+
+    // Per mesh ranges of surviving meshlets for glMultiDrawElements. Neighbouring
+    // survivors are merged into one range.
+    struct MeshletDrawList {
+        std::vector<GLsizei> counts;
+        std::vector<const void*> offsets;
+        std::vector<uint32_t> meshFirst; // first range of each mesh
+        std::vector<uint32_t> meshCount; // ranges of each mesh
+        std::vector<uint8_t> meshCulled; // mesh has meshlets and all of them were culled
+    };
+
+    // Frustum and normal cone culling of a model's meshlets on the job system.
+    class MeshletCuller {
+    public:
+        bool enabled = true;
+        bool coneCulling = true;
+
+        void cull(const Model& model, const glm::mat4& modelMatrix, const glm::mat4& viewProj,
+            const glm::vec3& cameraPos, JobSystem& jobs);
+
+        const MeshletDrawList& drawList() const { return list; }
+        const MeshletStats& stats() const { return frameStats; }
+        void renderImGui();
+
+    private:
+        std::vector<uint8_t> visible;
+        MeshletDrawList list;
+        MeshletStats frameStats;
+    };
+}
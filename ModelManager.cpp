@@ -1,5 +1,15 @@
 #include "ModelManager.h"
+#include "ResourcePools.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+#include "Timing.h"
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/quaternion.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/matrix_decompose.hpp>
 #define TINYGLTF_IMPLEMENTATION
 #include "tiny_gltf.h"
 
@@ -7,146 +17,571 @@
 
 namespace SS
 {
+    namespace
+    {
+        // Start of an accessor's data and the distance between its elements
+        const unsigned char* AccessorData(const tinygltf::Model& model, const tinygltf::Accessor& accessor, size_t& stride) {
+            const auto& view = model.bufferViews[accessor.bufferView];
+            int byteStride = accessor.ByteStride(view);
+            stride = byteStride > 0 ? static_cast<size_t>(byteStride) : 0;
+            return &model.buffers[view.buffer].data[view.byteOffset + accessor.byteOffset];
+        }
+
+        float ReadNormalized(const unsigned char* p, int componentType) {
+            switch (componentType) {
+            case TINYGLTF_COMPONENT_TYPE_FLOAT: return *reinterpret_cast<const float*>(p);
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: return *p / 255.0f;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: return *reinterpret_cast<const unsigned short*>(p) / 65535.0f;
+            default: return 0.0f;
+            }
+        }
+
+        // Keeps the largest triangles of a primitive. A subset of the real surface
+        // never hides more than the mesh itself would.
+        void SelectOccluder(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices,
+            std::vector<glm::vec3>& out) {
+            size_t triCount = indices.size() / 3;
+            std::vector<std::pair<float, size_t>> byArea;
+            byArea.reserve(triCount);
+            for (size_t t = 0; t < triCount; ++t) {
+                const glm::vec3& a = positions[indices[t * 3]];
+                const glm::vec3& b = positions[indices[t * 3 + 1]];
+                const glm::vec3& c = positions[indices[t * 3 + 2]];
+                byArea.push_back({ glm::length(glm::cross(b - a, c - a)), t });
+            }
+            size_t keep = std::min(triCount, Model::kOccluderTrianglesPerMesh);
+            std::partial_sort(byArea.begin(), byArea.begin() + keep, byArea.end(),
+                [](const auto& l, const auto& r) { return l.first > r.first; });
+            out.reserve(keep * 3);
+            for (size_t i = 0; i < keep; ++i) {
+                size_t t = byArea[i].second;
+                for (int v = 0; v < 3; ++v) {
+                    out.push_back(positions[indices[t * 3 + v]]);
+                }
+            }
+        }
+
+        void DecodePrimitive(const tinygltf::Model& gltfModel, const tinygltf::Primitive& prim, bool hasJoints,
+            ImportedPrimitive& out) {
+            SS_PROFILE_SCOPE("DecodePrimitive");
+            auto& vertices = out.vertices;
+            auto& indices = out.indices;
+            // load attributes
+            const auto& posAccessor = gltfModel.accessors[prim.attributes.at("POSITION")];
+            const auto& posView = gltfModel.bufferViews[posAccessor.bufferView];
+            const auto& posBuffer = gltfModel.buffers[posView.buffer];
+            const float* pos = reinterpret_cast<const float*>(&posBuffer.data[posView.byteOffset + posAccessor.byteOffset]);
+            size_t vc = posAccessor.count;
+            bool hasNormal = prim.attributes.count("NORMAL");
+            const float* normal = nullptr;
+            if (hasNormal) {
+                const auto& nA = gltfModel.accessors.at(prim.attributes.at("NORMAL"));
+                const auto& nv = gltfModel.bufferViews[nA.bufferView];
+                const auto& nb = gltfModel.buffers[nv.buffer];
+                normal = reinterpret_cast<const float*>(&nb.data[nv.byteOffset + nA.byteOffset]);
+            }
+            bool hasTex = prim.attributes.count("TEXCOORD_0");
+            const float* tex = nullptr;
+            if (hasTex) {
+                const auto& tA = gltfModel.accessors.at(prim.attributes.at("TEXCOORD_0"));
+                const auto& tv = gltfModel.bufferViews[tA.bufferView];
+                const auto& tb = gltfModel.buffers[tv.buffer];
+                tex = reinterpret_cast<const float*>(&tb.data[tv.byteOffset + tA.byteOffset]);
+            }
+            vertices.reserve(vc);
+            for (size_t i = 0; i < vc; ++i) {
+                glm::vec3 p(pos[i * 3], pos[i * 3 + 1], pos[i * 3 + 2]);
+                glm::vec3 n(0.f);
+                if (hasNormal) n = glm::vec3(normal[i * 3], normal[i * 3 + 1], normal[i * 3 + 2]);
+                glm::vec2 uv(0.f);
+                if (hasTex) uv = glm::vec2(tex[i * 2], tex[i * 2 + 1]);
+                vertices.push_back({ p,n,uv });
+            }
+            // load skin attributes
+            bool skinned = hasJoints && prim.attributes.count("JOINTS_0") && prim.attributes.count("WEIGHTS_0");
+            if (skinned) {
+                const auto& jA = gltfModel.accessors.at(prim.attributes.at("JOINTS_0"));
+                const auto& wA = gltfModel.accessors.at(prim.attributes.at("WEIGHTS_0"));
+                size_t jStride = 0, wStride = 0;
+                const unsigned char* joints = AccessorData(gltfModel, jA, jStride);
+                const unsigned char* weights = AccessorData(gltfModel, wA, wStride);
+                size_t wSize = tinygltf::GetComponentSizeInBytes(wA.componentType);
+                for (size_t i = 0; i < vc && i < jA.count && i < wA.count; ++i) {
+                    const unsigned char* j = joints + i * jStride;
+                    const unsigned char* w = weights + i * wStride;
+                    for (int k = 0; k < 4; ++k) {
+                        vertices[i].Joints[k] = jA.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT
+                            ? reinterpret_cast<const unsigned short*>(j)[k] : j[k];
+                        vertices[i].Weights[k] = ReadNormalized(w + k * wSize, wA.componentType);
+                    }
+                }
+            }
+            // load indices
+            const auto& idxA = gltfModel.accessors[prim.indices];
+            const auto& iv = gltfModel.bufferViews[idxA.bufferView];
+            const auto& ib = gltfModel.buffers[iv.buffer];
+            size_t count = idxA.count;
+            if (idxA.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
+                const unsigned short* buf = reinterpret_cast<const unsigned short*>(&ib.data[iv.byteOffset + idxA.byteOffset]);
+                indices.assign(buf, buf + count);
+            }
+            else if (idxA.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT) {
+                const unsigned int* buf = reinterpret_cast<const unsigned int*>(&ib.data[iv.byteOffset + idxA.byteOffset]);
+                indices.assign(buf, buf + count);
+            }
+            // Position-only copy, a depth pass then fetches 12 bytes per vertex instead of the full vertex
+            out.positions.resize(vertices.size());
+            for (size_t i = 0; i < vertices.size(); ++i) out.positions[i] = vertices[i].Position;
+            SelectOccluder(out.positions, indices, out.occluder);
+
+            MeshGL& meshGL = out.mesh;
+            meshGL.materialIndex = prim.material;
+            meshGL.skinned = skinned;
+            if (!vertices.empty()) {
+                meshGL.boundsMin = meshGL.boundsMax = vertices[0].Position;
+                for (const auto& v : vertices) {
+                    meshGL.boundsMin = glm::min(meshGL.boundsMin, v.Position);
+                    meshGL.boundsMax = glm::max(meshGL.boundsMax, v.Position);
+                }
+            }
+            // Skinned meshes deform every frame, so their meshlet bounds would go stale
+            if (!skinned && !vertices.empty()) {
+                bool doubleSided = prim.material >= 0 && prim.material < static_cast<int>(gltfModel.materials.size())
+                    && gltfModel.materials[prim.material].doubleSided;
+                BuildMeshlets(out.positions, indices, doubleSided, out.meshlets);
+                meshGL.meshletCount = static_cast<uint32_t>(out.meshlets.size());
+            }
+        }
+    }
+
     Model::Model() = default;
 
     Model::~Model() {
-        for (auto& mesh : meshes) {
-            glDeleteVertexArrays(1, &mesh.VAO);
-            glDeleteBuffers(1, &mesh.VBO);
-            glDeleteBuffers(1, &mesh.EBO);
+        ReleaseMeshes();
+        ReleaseMaterials();
+    }
+
+    Model& Model::operator=(Model&& other) noexcept {
+        if (this != &other) {
+            ReleaseMeshes();
+            ReleaseMaterials();
+            meshes = std::move(other.meshes);
+            textures = std::move(other.textures);
+            materials = std::move(other.materials);
+            occluderTriangles = std::move(other.occluderTriangles);
+            meshlets = std::move(other.meshlets);
+            gltfModel = std::move(other.gltfModel);
+            documentCharge = std::move(other.documentCharge);
+            imageCharge = std::move(other.imageCharge);
+            skeleton = std::move(other.skeleton);
+            animations = std::move(other.animations);
+            skinnedMeshes = std::move(other.skinnedMeshes);
+            cpuSkinningMs = other.cpuSkinningMs;
+            revision = other.revision;
+            filename = std::move(other.filename);
+            // The handles belong to this model now
+            other.meshes.clear();
+            other.textures.clear();
+            other.materials.clear();
         }
-        for (auto& tex : textures) {
-            glDeleteTextures(1, &tex.id);
+        return *this;
+    }
+
+    void Model::ReleaseMeshes() {
+        HandlePool<MeshGL>& pool = ResourcePools::Get().meshes;
+        for (MeshHandle handle : meshes) {
+            MeshGL* mesh = pool.get(handle);
+            if (!mesh) continue;
+            glDeleteVertexArrays(1, &mesh->VAO);
+            GpuMemory::deleteBuffers(1, &mesh->VBO);
+            GpuMemory::deleteBuffers(1, &mesh->EBO);
+            glDeleteVertexArrays(1, &mesh->positionVAO);
+            GpuMemory::deleteBuffers(1, &mesh->positionVBO);
+            if (mesh->cpuSkinnedVAO) glDeleteVertexArrays(1, &mesh->cpuSkinnedVAO);
+            if (mesh->cpuSkinnedVBO) GpuMemory::deleteBuffers(1, &mesh->cpuSkinnedVBO);
+            pool.remove(handle);
         }
+        meshes.clear();
+    }
+
+    const MeshGL& Model::GetMesh(size_t index) const {
+        return *ResourcePools::Get().meshes.get(meshes[index]);
     }
 
     bool Model::LoadFromFile(const std::string& filename) {
+        SS_PROFILE_SCOPE("Model::LoadFromFile");
+        auto import = Import(filename);
+        return import && LoadFromImport(*import);
+    }
+
+    std::unique_ptr<ModelImport> Model::Import(const std::string& filename, const std::atomic<bool>* cancel) {
+        SS_PROFILE_SCOPE("Model::Import");
+        auto cancelled = [cancel] { return cancel && cancel->load(std::memory_order_relaxed); };
+        auto import = std::make_unique<ModelImport>();
+        import->filename = filename;
+        tinygltf::Model& gltfModel = import->gltfModel;
         tinygltf::TinyGLTF loader;
         std::string err, warn;
         if (!loader.LoadBinaryFromFile(&gltfModel, &err, &warn, filename)) {
             std::cerr << "Failed to load glb: " << err << "\n";
-            return false;
+            return nullptr;
         }
         if (!warn.empty()) std::cout << "Warn: " << warn << "\n";
+        if (cancelled()) return nullptr;
+
+        size_t documentBytes = 0, imageBytes = 0;
+        for (const auto& buffer : gltfModel.buffers) documentBytes += buffer.data.capacity();
+        for (const auto& image : gltfModel.images) imageBytes += image.image.capacity();
+        import->documentCharge.set(MemoryTag::GltfDocument, documentBytes);
+        import->imageCharge.set(MemoryTag::DecodedImages, imageBytes);
 
-        // load textures
-        textures.resize(gltfModel.textures.size());
+        LoadSkeleton(gltfModel, import->skeleton);
+        LoadAnimations(gltfModel, import->animations);
+
+        // Decode images and primitives as background jobs, so frame work waiting
+        // on the job system never runs them; a cancelled import skips the jobs
+        // that have not started yet
+        JobSystem& jobs = JobSystem::Get();
+        JobCounter importJobs;
+        import->images.resize(gltfModel.images.size());
         for (size_t i = 0; i < gltfModel.images.size(); ++i) {
-            textures[i].id = LoadTextureImage(gltfModel.images[i]);
+            const auto& image = gltfModel.images[i];
+            if (image.bits != 8 || image.image.empty()) continue;
+            jobs.runBackground([&image, &prepared = import->images[i], cancelled] {
+                if (cancelled()) return;
+                MaterialLibrary::prepareTexture(image.image.data(), image.width, image.height, image.component, prepared);
+            }, &importJobs);
+        }
+        std::vector<const tinygltf::Primitive*> prims;
+        for (const auto& gltfMesh : gltfModel.meshes) {
+            for (const auto& prim : gltfMesh.primitives) prims.push_back(&prim);
         }
+        import->primitives.resize(prims.size());
+        bool hasJoints = import->skeleton.hasJoints();
+        for (size_t i = 0; i < prims.size(); ++i) {
+            jobs.runBackground([&gltfModel, &prim = *prims[i], &primitive = import->primitives[i], hasJoints, cancelled] {
+                if (cancelled()) return;
+                DecodePrimitive(gltfModel, prim, hasJoints, primitive);
+            }, &importJobs);
+        }
+        jobs.wait(importJobs);
+        if (cancelled()) return nullptr;
+        return import;
+    }
 
-        materials.resize(gltfModel.materials.size());
-        for (size_t i = 0; i < gltfModel.materials.size(); ++i) {
-            const auto& mat = gltfModel.materials[i];
-            if (mat.pbrMetallicRoughness.baseColorTexture.index >= 0)
-                materials[i].baseColorTexture = mat.pbrMetallicRoughness.baseColorTexture.index;
+    bool Model::LoadFromImport(ModelImport& import) {
+        SS_PROFILE_SCOPE("Model::LoadFromImport");
+        ReleaseMaterials();
+        ReleaseMeshes();
+        gltfModel = std::move(import.gltfModel);
+        documentCharge = std::move(import.documentCharge);
+        imageCharge = std::move(import.imageCharge);
+        skeleton = std::move(import.skeleton);
+        animations = std::move(import.animations);
+
+        // load textures and materials into the shared table
+        MaterialLibrary& library = MaterialLibrary::Get();
+        ResourcePools& pools = ResourcePools::Get();
+        textures.reserve(import.images.size());
+        for (size_t i = 0; i < import.images.size(); ++i) {
+            TextureGL texture;
+            texture.layer = import.images[i].empty() ? -1 : library.addPreparedTexture(import.images[i]);
+            textures.push_back(pools.textures.emplace(texture));
         }
+        LoadMaterials();
 
         // load meshes
-        meshes.clear();
-        for (const auto& gltfMesh : gltfModel.meshes) {
-            for (const auto& prim : gltfMesh.primitives) {
-                vertices.clear();
-                indices.clear();
-                // load attributes
-                const auto& posAccessor = gltfModel.accessors[prim.attributes.at("POSITION")];
-                const auto& posView = gltfModel.bufferViews[posAccessor.bufferView];
-                const auto& posBuffer = gltfModel.buffers[posView.buffer];
-                const float* pos = reinterpret_cast<const float*>(&posBuffer.data[posView.byteOffset + posAccessor.byteOffset]);
-                size_t vc = posAccessor.count;
-                bool hasNormal = prim.attributes.count("NORMAL");
-                const float* normal = nullptr;
-                if (hasNormal) {
-                    const auto& nA = gltfModel.accessors.at(prim.attributes.at("NORMAL"));
-                    const auto& nv = gltfModel.bufferViews[nA.bufferView];
-                    const auto& nb = gltfModel.buffers[nv.buffer];
-                    normal = reinterpret_cast<const float*>(&nb.data[nv.byteOffset + nA.byteOffset]);
-                }
-                bool hasTex = prim.attributes.count("TEXCOORD_0");
-                const float* tex = nullptr;
-                if (hasTex) {
-                    const auto& tA = gltfModel.accessors.at(prim.attributes.at("TEXCOORD_0"));
-                    const auto& tv = gltfModel.bufferViews[tA.bufferView];
-                    const auto& tb = gltfModel.buffers[tv.buffer];
-                    tex = reinterpret_cast<const float*>(&tb.data[tv.byteOffset + tA.byteOffset]);
-                }
-                for (size_t i = 0; i < vc; ++i) {
-                    glm::vec3 p(pos[i * 3], pos[i * 3 + 1], pos[i * 3 + 2]);
-                    glm::vec3 n(0.f);
-                    if (hasNormal) n = glm::vec3(normal[i * 3], normal[i * 3 + 1], normal[i * 3 + 2]);
-                    glm::vec2 uv(0.f);
-                    if (hasTex) uv = glm::vec2(tex[i * 2], tex[i * 2 + 1]);
-                    vertices.push_back({ p,n,uv });
-                }
-                // load indices
-                const auto& idxA = gltfModel.accessors[prim.indices];
-                const auto& iv = gltfModel.bufferViews[idxA.bufferView];
-                const auto& ib = gltfModel.buffers[iv.buffer];
-                size_t count = idxA.count;
-                if (idxA.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
-                    const unsigned short* buf = reinterpret_cast<const unsigned short*>(&ib.data[iv.byteOffset + idxA.byteOffset]);
-                    for (size_t i = 0; i < count; ++i) indices.push_back(buf[i]);
-                }
-                else if (idxA.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT) {
-                    const unsigned int* buf = reinterpret_cast<const unsigned int*>(&ib.data[iv.byteOffset + idxA.byteOffset]);
-                    for (size_t i = 0; i < count; ++i) indices.push_back(buf[i]);
-                }
-                MeshGL meshGL{};
-                meshGL.materialIndex = prim.material;
-                SetupMesh(vertices, indices, meshGL);
-                meshes.push_back(meshGL);
+        occluderTriangles.clear();
+        meshlets.clear();
+        skinnedMeshes.clear();
+        for (auto& primitive : import.primitives) {
+            MeshGL meshGL = primitive.mesh;
+            int material = meshGL.materialIndex;
+            if (material >= 0 && material < static_cast<int>(materials.size())) {
+                meshGL.materialSlot = materials[material].slot;
             }
+            if (meshGL.skinned) {
+                SkinnedMeshData data;
+                data.meshIndex = meshes.size();
+                data.bindVertices = primitive.vertices;
+                skinnedMeshes.push_back(std::move(data));
+            }
+            meshGL.meshletOffset = static_cast<uint32_t>(meshlets.size());
+            meshlets.insert(meshlets.end(), primitive.meshlets.begin(), primitive.meshlets.end());
+            SetupMesh(primitive, meshGL);
+            occluderTriangles.insert(occluderTriangles.end(), primitive.occluder.begin(), primitive.occluder.end());
+            meshes.push_back(pools.meshes.emplace(meshGL));
         }
+        // Shared by all models so a model swapped in never repeats the last revision
+        static uint32_t loads = 0;
+        revision = ++loads;
+        filename = import.filename;
         return true;
     }
 
-    GLuint Model::LoadTextureImage(const tinygltf::Image& image) {
-        GLuint texId;
-        glGenTextures(1, &texId);
-        glBindTexture(GL_TEXTURE_2D, texId);
-        GLenum format = (image.component == 4) ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height,
-            0, format, GL_UNSIGNED_BYTE, image.image.data());
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        return texId;
+    void Model::LoadMaterials() {
+        materials.resize(gltfModel.materials.size());
+        for (size_t i = 0; i < gltfModel.materials.size(); ++i) {
+            const auto& mat = gltfModel.materials[i];
+            const auto& pbr = mat.pbrMetallicRoughness;
+            MaterialData data;
+            if (pbr.baseColorFactor.size() == 4) {
+                data.baseColorFactor = glm::vec4(pbr.baseColorFactor[0], pbr.baseColorFactor[1],
+                    pbr.baseColorFactor[2], pbr.baseColorFactor[3]);
+            }
+            data.metallic = static_cast<float>(pbr.metallicFactor);
+            data.roughness = static_cast<float>(pbr.roughnessFactor);
+            int texture = pbr.baseColorTexture.index;
+            if (texture >= 0 && texture < static_cast<int>(gltfModel.textures.size())) {
+                int source = gltfModel.textures[texture].source;
+                const TextureGL* image = source >= 0 && source < static_cast<int>(textures.size())
+                    ? ResourcePools::Get().textures.get(textures[source]) : nullptr;
+                if (image && image->layer >= 0) {
+                    data.textureLayer = image->layer;
+                    data.flags |= MaterialHasBaseColorTexture;
+                }
+            }
+            if (mat.doubleSided) data.flags |= MaterialDoubleSided;
+            materials[i].slot = MaterialLibrary::Get().addMaterial(data);
+        }
+    }
+
+    void Model::ReleaseMaterials() {
+        MaterialLibrary& library = MaterialLibrary::Get();
+        HandlePool<TextureGL>& pool = ResourcePools::Get().textures;
+        for (TextureHandle handle : textures) {
+            if (const TextureGL* tex = pool.get(handle)) library.releaseTexture(tex->layer);
+            pool.remove(handle);
+        }
+        for (const auto& mat : materials) library.releaseMaterial(mat.slot);
+        textures.clear();
+        materials.clear();
     }
 
-    void Model::SetupMesh(const std::vector<Vertex>& verts, const std::vector<unsigned int>& inds, MeshGL& mesh) {
+    void Model::SetupMesh(const ImportedPrimitive& primitive, MeshGL& mesh) {
+        const VertexArray& verts = primitive.vertices;
+        const std::vector<unsigned int>& inds = primitive.indices;
+        const std::vector<glm::vec3>& positions = primitive.positions;
         glGenVertexArrays(1, &mesh.VAO);
         glGenBuffers(1, &mesh.VBO);
         glGenBuffers(1, &mesh.EBO);
 
         glBindVertexArray(mesh.VAO);
         glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-        glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(Vertex), verts.data(), GL_STATIC_DRAW);
+        GpuMemory::bufferData(mesh.VBO, GL_ARRAY_BUFFER, verts.size() * sizeof(Vertex), verts.data(), GL_STATIC_DRAW,
+            MemoryTag::GpuMeshBuffers);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, inds.size() * sizeof(unsigned int), inds.data(), GL_STATIC_DRAW);
+        GpuMemory::bufferData(mesh.EBO, GL_ELEMENT_ARRAY_BUFFER, inds.size() * sizeof(unsigned int), inds.data(), GL_STATIC_DRAW,
+            MemoryTag::GpuMeshBuffers);
+
+        SetupVertexAttributes();
 
+        glGenVertexArrays(1, &mesh.positionVAO);
+        glGenBuffers(1, &mesh.positionVBO);
+        glBindVertexArray(mesh.positionVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.positionVBO);
+        GpuMemory::bufferData(mesh.positionVBO, GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(),
+            GL_STATIC_DRAW, MemoryTag::GpuMeshBuffers);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+
+        glBindVertexArray(0);
+        mesh.indexCount = static_cast<GLsizei>(inds.size());
+    }
+
+    void Model::SetupVertexAttributes() {
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
         glEnableVertexAttribArray(2);
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoord));
+        glEnableVertexAttribArray(3);
+        glVertexAttribIPointer(3, 4, GL_UNSIGNED_SHORT, sizeof(Vertex), (void*)offsetof(Vertex, Joints));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Weights));
+    }
 
-        glBindVertexArray(0);
-        mesh.indexCount = static_cast<GLsizei>(inds.size());
+    void Model::LoadSkeleton(const tinygltf::Model& gltfModel, Skeleton& skeleton) {
+        skeleton = Skeleton{};
+        size_t nodeCount = gltfModel.nodes.size();
+        skeleton.parents.assign(nodeCount, -1);
+        skeleton.restTranslations.assign(nodeCount, glm::vec4(0.0f));
+        skeleton.restRotations.assign(nodeCount, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        skeleton.restScales.assign(nodeCount, glm::vec4(1.0f));
+
+        for (size_t i = 0; i < nodeCount; ++i) {
+            const auto& node = gltfModel.nodes[i];
+            for (int child : node.children) {
+                if (child >= 0 && child < static_cast<int>(nodeCount)) skeleton.parents[child] = static_cast<int>(i);
+            }
+            if (node.matrix.size() == 16) {
+                glm::mat4 m = glm::make_mat4(node.matrix.data());
+                glm::vec3 scale, translation, skew;
+                glm::vec4 perspective;
+                glm::quat rotation;
+                glm::decompose(m, scale, rotation, translation, skew, perspective);
+                skeleton.restTranslations[i] = glm::vec4(translation, 0.0f);
+                skeleton.restRotations[i] = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+                skeleton.restScales[i] = glm::vec4(scale, 0.0f);
+                continue;
+            }
+            if (node.translation.size() == 3)
+                skeleton.restTranslations[i] = glm::vec4(node.translation[0], node.translation[1], node.translation[2], 0.0f);
+            if (node.rotation.size() == 4)
+                skeleton.restRotations[i] = glm::vec4(node.rotation[0], node.rotation[1], node.rotation[2], node.rotation[3]);
+            if (node.scale.size() == 3)
+                skeleton.restScales[i] = glm::vec4(node.scale[0], node.scale[1], node.scale[2], 0.0f);
+        }
+
+        // Breadth first from the roots so parents are evaluated before children
+        for (size_t i = 0; i < nodeCount; ++i) {
+            if (skeleton.parents[i] < 0) skeleton.evaluationOrder.push_back(static_cast<int>(i));
+        }
+        for (size_t head = 0; head < skeleton.evaluationOrder.size(); ++head) {
+            for (int child : gltfModel.nodes[skeleton.evaluationOrder[head]].children) {
+                skeleton.evaluationOrder.push_back(child);
+            }
+        }
+
+        if (gltfModel.skins.empty()) return;
+        if (gltfModel.skins.size() > 1) std::cout << "Warn: only the first of " << gltfModel.skins.size() << " skins is used\n";
+        const auto& skin = gltfModel.skins[0];
+        skeleton.jointNodes = skin.joints;
+        skeleton.inverseBindMatrices.assign(skin.joints.size(), glm::mat4(1.0f));
+        if (skin.inverseBindMatrices >= 0) {
+            const auto& accessor = gltfModel.accessors[skin.inverseBindMatrices];
+            size_t stride = 0;
+            const unsigned char* data = AccessorData(gltfModel, accessor, stride);
+            for (size_t j = 0; j < skin.joints.size() && j < accessor.count; ++j) {
+                skeleton.inverseBindMatrices[j] = glm::make_mat4(reinterpret_cast<const float*>(data + j * stride));
+            }
+        }
+    }
+
+    void Model::LoadAnimations(const tinygltf::Model& gltfModel, std::vector<AnimationClip>& animations) {
+        animations.clear();
+        for (const auto& gltfAnim : gltfModel.animations) {
+            AnimationClip clip;
+            clip.name = gltfAnim.name;
+            for (const auto& gltfChannel : gltfAnim.channels) {
+                AnimationChannel channel;
+                channel.node = gltfChannel.target_node;
+                if (gltfChannel.target_path == "translation") channel.path = AnimationPath::Translation;
+                else if (gltfChannel.target_path == "rotation") channel.path = AnimationPath::Rotation;
+                else if (gltfChannel.target_path == "scale") channel.path = AnimationPath::Scale;
+                else continue; // morph target weights are not supported
+
+                const auto& sampler = gltfAnim.samplers[gltfChannel.sampler];
+                const auto& input = gltfModel.accessors[sampler.input];
+                const auto& output = gltfModel.accessors[sampler.output];
+                if (input.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || output.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT) {
+                    std::cout << "Warn: skipping non-float animation channel in " << clip.name << "\n";
+                    continue;
+                }
+                channel.step = sampler.interpolation == "STEP";
+                // CUBICSPLINE stores in-tangent, value, out-tangent per key; only the values are used
+                bool cubic = sampler.interpolation == "CUBICSPLINE";
+                int components = channel.path == AnimationPath::Rotation ? 4 : 3;
+
+                size_t inStride = 0, outStride = 0;
+                const unsigned char* times = AccessorData(gltfModel, input, inStride);
+                const unsigned char* values = AccessorData(gltfModel, output, outStride);
+                for (size_t k = 0; k < input.count; ++k) {
+                    channel.times.push_back(*reinterpret_cast<const float*>(times + k * inStride));
+                    const float* v = reinterpret_cast<const float*>(values + (cubic ? k * 3 + 1 : k) * outStride);
+                    channel.values.push_back(components == 4 ? glm::vec4(v[0], v[1], v[2], v[3]) : glm::vec4(v[0], v[1], v[2], 0.0f));
+                }
+                if (!channel.times.empty()) clip.duration = std::max(clip.duration, channel.times.back());
+                clip.channels.push_back(std::move(channel));
+            }
+            animations.push_back(std::move(clip));
+        }
+    }
+
+    bool Model::GetBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const {
+        if (meshes.empty()) return false;
+        boundsMin = GetMesh(0).boundsMin;
+        boundsMax = GetMesh(0).boundsMax;
+        for (size_t i = 1; i < meshes.size(); ++i) {
+            const MeshGL& mesh = GetMesh(i);
+            boundsMin = glm::min(boundsMin, mesh.boundsMin);
+            boundsMax = glm::max(boundsMax, mesh.boundsMax);
+        }
+        return true;
+    }
+
+    size_t Model::GetSkinnedVertexCount() const {
+        size_t count = 0;
+        for (const auto& data : skinnedMeshes) count += data.bindVertices.size();
+        return count;
     }
 
-    void Model::Draw(GLuint shaderProgram) const {
-        for (const auto& mesh : meshes) {
-            GLint loc = glGetUniformLocation(shaderProgram, "hasBaseColor");
-            bool hasBase = mesh.materialIndex >= 0 && materials[mesh.materialIndex].baseColorTexture >= 0;
-            glUniform1i(loc, hasBase);
-            if (hasBase) {
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, textures[materials[mesh.materialIndex].baseColorTexture].id);
-                glUniform1i(glGetUniformLocation(shaderProgram, "baseColorTexture"), 0);
+    void Model::UpdateCpuSkinning(const std::vector<glm::mat4>& palette) {
+        SS_PROFILE_SCOPE("Model::UpdateCpuSkinning");
+        auto start = std::chrono::steady_clock::now();
+        for (auto& data : skinnedMeshes) {
+            data.skinnedVertices.resize(data.bindVertices.size());
+            JobSystem::Get().parallelFor(data.bindVertices.size(), 2048, [&](size_t begin, size_t end) {
+                SkinVertices(&data.bindVertices[begin], &data.skinnedVertices[begin], end - begin, palette.data(), palette.size());
+            });
+
+            MeshGL& mesh = *ResourcePools::Get().meshes.get(meshes[data.meshIndex]);
+            GLsizeiptr size = static_cast<GLsizeiptr>(data.skinnedVertices.size() * sizeof(Vertex));
+            if (!mesh.cpuSkinnedVAO) {
+                glGenVertexArrays(1, &mesh.cpuSkinnedVAO);
+                glGenBuffers(1, &mesh.cpuSkinnedVBO);
+                glBindVertexArray(mesh.cpuSkinnedVAO);
+                glBindBuffer(GL_ARRAY_BUFFER, mesh.cpuSkinnedVBO);
+                GpuMemory::bufferData(mesh.cpuSkinnedVBO, GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW, MemoryTag::GpuStreamBuffers);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+                SetupVertexAttributes();
+                glBindVertexArray(0);
             }
-            glBindVertexArray(mesh.VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, mesh.cpuSkinnedVBO);
+            // Respecifying the store orphans last frame's copy instead of syncing on it
+            GpuMemory::bufferData(mesh.cpuSkinnedVBO, GL_ARRAY_BUFFER, size, data.skinnedVertices.data(), GL_STREAM_DRAW,
+                MemoryTag::GpuStreamBuffers);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        cpuSkinningMs = elapsedMs(start);
+    }
+
+    void Model::Draw(GLuint shaderProgram, SkinningMode skinning, const std::vector<uint8_t>* visibility,
+        const MeshletDrawList* meshlets) const {
+        // Textures and material parameters come from the shared table bound by
+        // MaterialLibrary::bind(), a draw only selects its row
+        GLint skinnedLoc = glGetUniformLocation(shaderProgram, "skinned");
+        GLint materialLoc = glGetUniformLocation(shaderProgram, "materialIndex");
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            if (visibility && i < visibility->size() && !(*visibility)[i]) continue;
+            const MeshGL& mesh = GetMesh(i);
+            bool cpuSkinned = mesh.skinned && skinning == SkinningMode::Cpu && mesh.cpuSkinnedVAO;
+            bool gpuSkinned = mesh.skinned && skinning == SkinningMode::Gpu;
+            glUniform1i(skinnedLoc, gpuSkinned);
+            glUniform1i(materialLoc, mesh.materialSlot);
+            glBindVertexArray(cpuSkinned ? mesh.cpuSkinnedVAO : mesh.VAO);
+            if (meshlets && mesh.meshletCount > 0 && i < meshlets->meshCount.size()) {
+                if (meshlets->meshCulled[i]) continue;
+                GLsizei ranges = static_cast<GLsizei>(meshlets->meshCount[i]);
+                uint32_t first = meshlets->meshFirst[i];
+                glMultiDrawElements(GL_TRIANGLES, &meshlets->counts[first], GL_UNSIGNED_INT, &meshlets->offsets[first], ranges);
+                continue;
+            }
+            glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0);
+        }
+    }
+
+    void Model::DrawDepth(GLuint shaderProgram, SkinningMode skinning) const {
+        GLint skinnedLoc = glGetUniformLocation(shaderProgram, "skinned");
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            const MeshGL& mesh = GetMesh(i);
+            bool cpuSkinned = mesh.skinned && skinning == SkinningMode::Cpu && mesh.cpuSkinnedVAO;
+            bool gpuSkinned = mesh.skinned && skinning == SkinningMode::Gpu;
+            glUniform1i(skinnedLoc, gpuSkinned);
+            glBindVertexArray(cpuSkinned ? mesh.cpuSkinnedVAO : gpuSkinned ? mesh.VAO : mesh.positionVAO);
             glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0);
         }
     }
@@ -1,9 +1,18 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <memory>
+#include <atomic>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
 #include "tiny_gltf.h"
+#include "Animation.h"
+#include "MaterialLibrary.h"
+#include "Meshlet.h"
+#include "MemoryTracker.h"
+#include "HandlePool.h"
 
 namespace SS
 {
@@ -11,40 +20,150 @@ namespace SS
         glm::vec3 Position;
         glm::vec3 Normal;
         glm::vec2 TexCoord;
+        glm::u16vec4 Joints{ 0 };
+        glm::vec4 Weights{ 0.0f };
     };
 
+    using VertexArray = TrackedVector<Vertex, MemoryTag::Vertices>;
+
     struct MeshGL {
         GLuint VAO = 0;
         GLuint VBO = 0;
         GLuint EBO = 0;
         GLsizei indexCount = 0;
-        int materialIndex = -1;
+        int materialIndex = -1; // glTF material
+        int materialSlot = MaterialLibrary::kDefaultMaterial; // row in the shared material table
+        glm::vec3 boundsMin{ 0.0f };
+        glm::vec3 boundsMax{ 0.0f };
+        bool skinned = false;
+        // Range in Model::GetMeshlets(), empty for skinned meshes
+        uint32_t meshletOffset = 0;
+        uint32_t meshletCount = 0;
+        // Tightly packed positions sharing EBO, for depth-only passes
+        GLuint positionVAO = 0;
+        GLuint positionVBO = 0;
+        // Streamed output of the CPU skinning path, created on first use
+        GLuint cpuSkinnedVAO = 0;
+        GLuint cpuSkinnedVBO = 0;
     };
 
+    // MaterialLibrary texture index (size class and layer) holding one glTF image
     struct TextureGL {
-        GLuint id = 0;
+        int layer = -1;
     };
 
+    class Model;
+    using MeshHandle = Handle<MeshGL>;
+    using TextureHandle = Handle<TextureGL>;
+    using ModelHandle = Handle<Model>;
+
     struct Material {
-        int baseColorTexture = -1;
+        int slot = MaterialLibrary::kDefaultMaterial;
+    };
+
+    // CPU side of one glTF primitive, decoded on a worker before its GL upload
+    struct ImportedPrimitive {
+        VertexArray vertices;
+        std::vector<glm::vec3> positions; // depth-only stream, also used for meshlets
+        std::vector<unsigned int> indices;
+        std::vector<Meshlet> meshlets;
+        std::vector<glm::vec3> occluder; // largest triangles, three positions each
+        MeshGL mesh;
+    };
+
+    // Everything LoadFromFile decodes before touching GL
+    struct ModelImport {
+        std::string filename;
+        tinygltf::Model gltfModel;
+        Skeleton skeleton;
+        std::vector<AnimationClip> animations;
+        std::vector<ImageBuffer> images; // RGBA, empty when unusable
+        std::vector<ImportedPrimitive> primitives;
+        MemoryCharge documentCharge; // gltfModel's buffers
+        MemoryCharge imageCharge;    // gltfModel's decoded images
     };
 
+    // Meshes and textures live in ResourcePools and the model keeps their
+    // handles; models are normally pooled too and referred to by ModelHandle.
     class Model {
     public:
         Model();
         ~Model();
+        Model(Model&& other) = default;
+        Model& operator=(Model&& other) noexcept;
+        Model(const Model&) = delete;
+        Model& operator=(const Model&) = delete;
+
         bool LoadFromFile(const std::string& filename);
-        void Draw(GLuint shaderProgram) const;
+        // First half of LoadFromFile: parses and decodes without GL, on any thread.
+        // Returns null on failure, or early once `cancel` is set.
+        static std::unique_ptr<ModelImport> Import(const std::string& filename,
+            const std::atomic<bool>* cancel = nullptr);
+        // Second half: uploads an import on the GL context thread.
+        bool LoadFromImport(ModelImport& import);
+        // `skinning` picks the skinned meshes' vertex source; it is passed per draw
+        // so instances of one model can be skinned differently without touching
+        // shared state. `visibility` (one entry per mesh) skips meshes rejected by
+        // culling. With `meshlets`, meshes that have meshlets only draw the
+        // surviving ranges.
+        void Draw(GLuint shaderProgram, SkinningMode skinning, const std::vector<uint8_t>* visibility = nullptr,
+            const MeshletDrawList* meshlets = nullptr) const;
+        // Depth-only draw. Static meshes use the position stream, skinned meshes
+        // follow `skinning` so their silhouette matches Draw.
+        void DrawDepth(GLuint shaderProgram, SkinningMode skinning) const;
+        // Changes with every successful load, unique across models, lets caches
+        // notice a new model.
+        uint32_t GetRevision() const { return revision; }
+        // Path of the last successful load, empty before one.
+        const std::string& GetFilename() const { return filename; }
+
+        size_t GetMeshCount() const { return meshes.size(); }
+        const MeshGL& GetMesh(size_t index) const;
+        const std::vector<MeshHandle>& GetMeshHandles() const { return meshes; }
+        const std::vector<Meshlet>& GetMeshlets() const { return meshlets; }
+        // Bind pose bounds of all meshes, false when nothing is loaded.
+        bool GetBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+        // Simplified occluder, three model-space positions per triangle.
+        const std::vector<glm::vec3>& GetOccluderTriangles() const { return occluderTriangles; }
+
+        static constexpr size_t kOccluderTrianglesPerMesh = 512;
+
+        const Skeleton& GetSkeleton() const { return skeleton; }
+        const std::vector<AnimationClip>& GetAnimations() const { return animations; }
+
+        // Skins every skinned mesh on the job system and streams the result to the GPU.
+        void UpdateCpuSkinning(const std::vector<glm::mat4>& palette);
+        double GetCpuSkinningMs() const { return cpuSkinningMs; }
+        size_t GetSkinnedVertexCount() const;
 
     private:
-        std::vector<MeshGL> meshes;
-        std::vector<Vertex> vertices;
-        std::vector<unsigned int> indices;
-        std::vector<TextureGL> textures;
+        std::vector<MeshHandle> meshes;
+        std::vector<TextureHandle> textures;
         std::vector<Material> materials;
+        std::vector<glm::vec3> occluderTriangles;
+        std::vector<Meshlet> meshlets;
         tinygltf::Model gltfModel;
+        MemoryCharge documentCharge;
+        MemoryCharge imageCharge;
+
+        struct SkinnedMeshData {
+            size_t meshIndex = 0;
+            VertexArray bindVertices;
+            VertexArray skinnedVertices;
+        };
+        Skeleton skeleton;
+        std::vector<AnimationClip> animations;
+        std::vector<SkinnedMeshData> skinnedMeshes;
+        double cpuSkinningMs = 0.0;
+        uint32_t revision = 0;
+        std::string filename;
 
-        void SetupMesh(const std::vector<Vertex>& verts, const std::vector<unsigned int>& inds, MeshGL& mesh);
-        GLuint LoadTextureImage(const tinygltf::Image& image);
+        void SetupMesh(const ImportedPrimitive& primitive, MeshGL& mesh);
+        void LoadMaterials();
+        void ReleaseMaterials();
+        void ReleaseMeshes();
+        static void LoadSkeleton(const tinygltf::Model& gltfModel, Skeleton& skeleton);
+        static void LoadAnimations(const tinygltf::Model& gltfModel, std::vector<AnimationClip>& animations);
+        static void SetupVertexAttributes();
     };
 }
@@ -0,0 +1,213 @@
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+#include "Timing.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SS_OCCLUSION_SSE 1
+#endif
+
+namespace SS
+{
+    namespace
+    {
+        constexpr float kMinW = 1e-4f;
+        constexpr int kTilesX = OcclusionCuller::kWidth / OcclusionCuller::kTileSize;
+        constexpr int kTilesY = OcclusionCuller::kHeight / OcclusionCuller::kTileSize;
+    }
+
+    OcclusionCuller::OcclusionCuller()
+        : depthBuffer(kWidth * kHeight, 1.0f), tileMaxDepth(kTilesX * kTilesY, 1.0f)
+    {
+    }
+
+    void OcclusionCuller::beginFrame(const glm::mat4& vp) {
+        viewProj = vp;
+        triangles.clear();
+        frameStats = {};
+    }
+
+    void OcclusionCuller::addOccluder(const std::vector<glm::vec3>& tris, const glm::mat4& model) {
+        auto start = std::chrono::steady_clock::now();
+        glm::mat4 mvp = viewProj * model;
+
+        for (size_t t = 0; t + 2 < tris.size(); t += 3) {
+            ScreenTriangle st;
+            bool behind = false;
+            float depth = 0.0f;
+            for (int v = 0; v < 3; ++v) {
+                glm::vec4 clip = mvp * glm::vec4(tris[t + v], 1.0f);
+                if (clip.w < kMinW) { behind = true; break; }
+                float invW = 1.0f / clip.w;
+                st.x[v] = (clip.x * invW * 0.5f + 0.5f) * kWidth;
+                st.y[v] = (clip.y * invW * 0.5f + 0.5f) * kHeight;
+                depth = std::max(depth, clip.z * invW * 0.5f + 0.5f);
+            }
+            // Triangles crossing the near plane are dropped rather than clipped;
+            // losing an occluder only makes the test more conservative.
+            if (behind || depth > 1.0f) continue;
+
+            float area = (st.x[1] - st.x[0]) * (st.y[2] - st.y[0]) - (st.x[2] - st.x[0]) * (st.y[1] - st.y[0]);
+            if (area <= 0.0f) continue; // back facing or degenerate
+
+            st.depth = depth;
+            st.minX = std::max(0, static_cast<int>(std::floor(std::min({ st.x[0], st.x[1], st.x[2] }))));
+            st.maxX = std::min(kWidth - 1, static_cast<int>(std::ceil(std::max({ st.x[0], st.x[1], st.x[2] }))));
+            st.minY = std::max(0, static_cast<int>(std::floor(std::min({ st.y[0], st.y[1], st.y[2] }))));
+            st.maxY = std::min(kHeight - 1, static_cast<int>(std::ceil(std::max({ st.y[0], st.y[1], st.y[2] }))));
+            if (st.minX > st.maxX || st.minY > st.maxY) continue;
+
+            triangles.push_back(st);
+        }
+        frameStats.occluderTriangles = static_cast<int>(triangles.size());
+        frameStats.rasterMs += elapsedMs(start);
+    }
+
+    void OcclusionCuller::rasterize() {
+        auto start = std::chrono::steady_clock::now();
+        constexpr int bandHeight = kTileSize;
+        JobSystem::Get().parallelFor(kTilesY, 1, [this](size_t begin, size_t end) {
+            for (size_t band = begin; band < end; ++band) {
+                rasterizeBand(static_cast<int>(band) * bandHeight, static_cast<int>(band + 1) * bandHeight);
+            }
+        });
+        frameStats.rasterMs += elapsedMs(start);
+    }
+
+    void OcclusionCuller::rasterizeBand(int y0, int y1) {
+        std::fill(depthBuffer.begin() + y0 * kWidth, depthBuffer.begin() + y1 * kWidth, 1.0f);
+
+        for (const auto& tri : triangles) {
+            if (tri.maxY < y0 || tri.minY >= y1) continue;
+
+            // Edge functions E(x, y) = A*x + B*y + C, positive inside a CCW triangle.
+            float A[3], B[3], C[3];
+            for (int e = 0; e < 3; ++e) {
+                int n = (e + 1) % 3;
+                A[e] = tri.y[e] - tri.y[n];
+                B[e] = tri.x[n] - tri.x[e];
+                C[e] = -(A[e] * tri.x[e] + B[e] * tri.y[e]);
+            }
+
+            int rowStart = std::max(tri.minY, y0);
+            int rowEnd = std::min(tri.maxY, y1 - 1);
+            int colStart = tri.minX & ~3;
+
+            for (int y = rowStart; y <= rowEnd; ++y) {
+                float py = y + 0.5f;
+                float* row = &depthBuffer[y * kWidth];
+#ifdef SS_OCCLUSION_SSE
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 triDepth = _mm_set1_ps(tri.depth);
+                const __m128 step = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+                __m128 a0 = _mm_set1_ps(A[0]), a1 = _mm_set1_ps(A[1]), a2 = _mm_set1_ps(A[2]);
+                __m128 r0 = _mm_set1_ps(B[0] * py + C[0]);
+                __m128 r1 = _mm_set1_ps(B[1] * py + C[1]);
+                __m128 r2 = _mm_set1_ps(B[2] * py + C[2]);
+                for (int x = colStart; x <= tri.maxX; x += 4) {
+                    __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), step);
+                    __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), r0);
+                    __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), r1);
+                    __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), r2);
+                    __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                    if (_mm_movemask_ps(inside) == 0) continue;
+                    __m128 current = _mm_loadu_ps(row + x);
+                    __m128 closer = _mm_min_ps(current, triDepth);
+                    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, current)));
+                }
+#else
+                for (int x = colStart; x <= tri.maxX; ++x) {
+                    float px = x + 0.5f;
+                    if (A[0] * px + B[0] * py + C[0] >= 0.0f &&
+                        A[1] * px + B[1] * py + C[1] >= 0.0f &&
+                        A[2] * px + B[2] * py + C[2] >= 0.0f) {
+                        row[x] = std::min(row[x], tri.depth);
+                    }
+                }
+#endif
+            }
+        }
+
+        // Refresh the hierarchical level for the tiles covered by this band.
+        for (int ty = y0 / kTileSize; ty < y1 / kTileSize; ++ty) {
+            for (int tx = 0; tx < kTilesX; ++tx) {
+                float maxDepth = 0.0f;
+                for (int y = ty * kTileSize; y < (ty + 1) * kTileSize; ++y) {
+                    const float* row = &depthBuffer[y * kWidth + tx * kTileSize];
+                    for (int x = 0; x < kTileSize; ++x) maxDepth = std::max(maxDepth, row[x]);
+                }
+                tileMaxDepth[ty * kTilesX + tx] = maxDepth;
+            }
+        }
+    }
+
+    bool OcclusionCuller::isVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& model) {
+        auto start = std::chrono::steady_clock::now();
+        ++frameStats.tested;
+
+        glm::mat4 mvp = viewProj * model;
+        float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, minZ = 1e30f;
+        for (int c = 0; c < 8; ++c) {
+            glm::vec3 corner((c & 1) ? boundsMax.x : boundsMin.x,
+                (c & 2) ? boundsMax.y : boundsMin.y,
+                (c & 4) ? boundsMax.z : boundsMin.z);
+            glm::vec4 clip = mvp * glm::vec4(corner, 1.0f);
+            if (clip.w < kMinW) {
+                // Box straddles the near plane, treat it as visible
+                frameStats.testMs += elapsedMs(start);
+                return true;
+            }
+            float invW = 1.0f / clip.w;
+            float sx = (clip.x * invW * 0.5f + 0.5f) * kWidth;
+            float sy = (clip.y * invW * 0.5f + 0.5f) * kHeight;
+            minX = std::min(minX, sx); maxX = std::max(maxX, sx);
+            minY = std::min(minY, sy); maxY = std::max(maxY, sy);
+            minZ = std::min(minZ, clip.z * invW * 0.5f + 0.5f);
+        }
+
+        if (maxX < 0.0f || maxY < 0.0f || minX >= kWidth || minY >= kHeight || minZ > 1.0f) {
+            ++frameStats.outsideFrustum;
+            frameStats.testMs += elapsedMs(start);
+            return false;
+        }
+
+        int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+        int x1 = std::min(kWidth - 1, static_cast<int>(std::ceil(maxX)));
+        int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+        int y1 = std::min(kHeight - 1, static_cast<int>(std::ceil(maxY)));
+
+        bool visible = false;
+        for (int ty = y0 / kTileSize; ty <= y1 / kTileSize && !visible; ++ty) {
+            for (int tx = x0 / kTileSize; tx <= x1 / kTileSize && !visible; ++tx) {
+                if (tileMaxDepth[ty * kTilesX + tx] < minZ) continue; // whole tile is in front
+
+                int py0 = std::max(y0, ty * kTileSize), py1 = std::min(y1, (ty + 1) * kTileSize - 1);
+                int px0 = std::max(x0, tx * kTileSize), px1 = std::min(x1, (tx + 1) * kTileSize - 1);
+                for (int y = py0; y <= py1 && !visible; ++y) {
+                    for (int x = px0; x <= px1; ++x) {
+                        if (depthBuffer[y * kWidth + x] >= minZ) { visible = true; break; }
+                    }
+                }
+            }
+        }
+
+        if (!visible) ++frameStats.occluded;
+        frameStats.testMs += elapsedMs(start);
+        return visible;
+    }
+
+    void OcclusionCuller::renderImGui() {
+        ImGui::Begin("Occlusion Culling");
+        ImGui::Checkbox("Enabled", &enabled);
+        ImGui::Text("Depth buffer: %dx%d, %u threads", kWidth, kHeight, JobSystem::Get().threadCount());
+        ImGui::Text("Occluder triangles: %d", frameStats.occluderTriangles);
+        ImGui::Text("Tested: %d  Occluded: %d  Outside frustum: %d",
+            frameStats.tested, frameStats.occluded, frameStats.outsideFrustum);
+        ImGui::Text("CPU: raster %.3f ms, test %.3f ms", frameStats.rasterMs, frameStats.testMs);
+        ImGui::End();
+    }
+}
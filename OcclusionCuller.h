@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace SS
+{
+    struct OcclusionStats {
+        int occluderTriangles = 0;
+        int tested = 0;
+        int occluded = 0;
+        int outsideFrustum = 0;
+        double rasterMs = 0.0;
+        double testMs = 0.0;
+    };
+
+    // Low resolution software depth buffer. Occluder triangles are rasterized with
+    // SSE across worker threads, then occludee bounding boxes are tested against it
+    // (first per 8x8 tile max depth, then per pixel) before draw submission.
+    class OcclusionCuller {
+    public:
+        static constexpr int kWidth = 256;
+        static constexpr int kHeight = 128;
+        static constexpr int kTileSize = 8;
+
+        bool enabled = true;
+
+        OcclusionCuller();
+
+        void beginFrame(const glm::mat4& viewProj);
+        // `triangles` holds three positions per triangle, in model space.
+        void addOccluder(const std::vector<glm::vec3>& triangles, const glm::mat4& model);
+        void rasterize();
+        // Returns false when the box is outside the frustum or fully hidden.
+        bool isVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& model);
+
+        const OcclusionStats& stats() const { return frameStats; }
+        void renderImGui();
+
+    private:
+        struct ScreenTriangle {
+            float x[3];
+            float y[3];
+            float depth; // farthest vertex, keeps the occluder conservative
+            int minX, maxX, minY, maxY;
+        };
+
+        glm::mat4 viewProj{ 1.0f };
+        std::vector<ScreenTriangle> triangles;
+        std::vector<float> depthBuffer;
+        std::vector<float> tileMaxDepth;
+        OcclusionStats frameStats;
+
+        void rasterizeBand(int y0, int y1);
+    };
+}
@@ -0,0 +1,260 @@
+#include "Profiler.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <cstdio>
+
+namespace SS
+{
+    std::atomic<bool> Profiler::enabled{ false };
+
+    namespace
+    {
+        // Single producer ring: only the owning thread writes, readers copy a
+        // window behind `head` and discard anything overwritten meanwhile.
+        struct ThreadBuffer {
+            uint32_t threadId = 0;
+            std::string name;
+            std::vector<ProfileEvent> events = std::vector<ProfileEvent>(Profiler::kEventsPerThread);
+            std::atomic<uint64_t> head{ 0 };
+            bool retired = false; // owner exited, events stay readable until reused
+        };
+
+        std::mutex registryMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> registry;
+        uint32_t nextThreadId = 1;
+
+        thread_local ThreadBuffer* localBuffer = nullptr;
+        thread_local uint32_t localDepth = 0;
+
+        // Retires the thread's buffer when the thread exits, so short-lived
+        // threads (benchmark job systems) recycle buffers instead of adding one each
+        struct BufferOwner {
+            ~BufferOwner() {
+                if (!localBuffer) return;
+                std::lock_guard<std::mutex> lock(registryMutex);
+                localBuffer->retired = true;
+                localBuffer = nullptr;
+            }
+        };
+        thread_local BufferOwner localOwner;
+
+        uint64_t frameStarts[Profiler::kFrameHistory] = {};
+        std::atomic<uint64_t> frameCount{ 0 };
+
+        const auto epoch = std::chrono::steady_clock::now();
+
+        ThreadBuffer& threadBuffer() {
+            if (!localBuffer) {
+                (void)localOwner;
+                std::lock_guard<std::mutex> lock(registryMutex);
+                auto retired = std::find_if(registry.begin(), registry.end(),
+                    [](const auto& buffer) { return buffer->retired; });
+                ThreadBuffer* buffer = nullptr;
+                if (retired != registry.end()) {
+                    buffer = retired->get();
+                    buffer->retired = false;
+                    buffer->head.store(0, std::memory_order_relaxed);
+                }
+                else {
+                    registry.push_back(std::make_unique<ThreadBuffer>());
+                    buffer = registry.back().get();
+                }
+                buffer->threadId = nextThreadId++;
+                buffer->name = "Thread " + std::to_string(buffer->threadId);
+                localBuffer = buffer;
+            }
+            return *localBuffer;
+        }
+
+        void writeEscaped(std::ostream& os, const char* s) {
+            for (; *s; ++s) {
+                if (*s == '"' || *s == '\\') os << '\\';
+                os << *s;
+            }
+        }
+
+        // Flame view state
+        int flameFrames = 8;
+        bool flamePaused = false;
+        std::vector<ProfileThreadEvents> flameEvents;
+        uint64_t flameStart = 0;
+        uint64_t flameEnd = 0;
+        char exportPath[256] = "profile_trace.json";
+    }
+
+    void Profiler::setEnabled(bool on) {
+        enabled.store(on, std::memory_order_relaxed);
+    }
+
+    uint64_t Profiler::nowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count());
+    }
+
+    void Profiler::setThreadName(const char* name) {
+        ThreadBuffer& buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer.name = name;
+    }
+
+    void Profiler::record(const ProfileEvent& event) {
+        ThreadBuffer& buffer = threadBuffer();
+        uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        buffer.events[head % kEventsPerThread] = event;
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Profiler::markFrame() {
+        uint64_t frame = frameCount.load(std::memory_order_relaxed);
+        frameStarts[frame % kFrameHistory] = nowNs();
+        frameCount.store(frame + 1, std::memory_order_release);
+    }
+
+    uint64_t Profiler::frameStartNs(size_t framesAgo) {
+        uint64_t count = frameCount.load(std::memory_order_acquire);
+        if (framesAgo >= count || framesAgo >= kFrameHistory) return 0;
+        return frameStarts[(count - 1 - framesAgo) % kFrameHistory];
+    }
+
+    void Profiler::snapshot(uint64_t sinceNs, std::vector<ProfileThreadEvents>& out) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        out.resize(registry.size());
+        for (size_t t = 0; t < registry.size(); ++t) {
+            const ThreadBuffer& buffer = *registry[t];
+            ProfileThreadEvents& thread = out[t];
+            thread.threadId = buffer.threadId;
+            thread.threadName = buffer.name;
+
+            uint64_t head = buffer.head.load(std::memory_order_acquire);
+            // Leave a margin so events being overwritten right now are skipped
+            uint64_t window = kEventsPerThread - kEventsPerThread / 8;
+            uint64_t first = head > window ? head - window : 0;
+            auto& events = thread.events;
+            events.clear();
+            for (uint64_t i = first; i < head; ++i) {
+                events.push_back(buffer.events[i % kEventsPerThread]);
+            }
+            // If the writer lapped us while copying, drop the slots it reused
+            uint64_t headAfter = buffer.head.load(std::memory_order_acquire);
+            size_t lost = headAfter - first > kEventsPerThread ? static_cast<size_t>(headAfter - first - kEventsPerThread) : 0;
+            events.erase(events.begin(), events.begin() + std::min(lost, events.size()));
+            events.erase(std::remove_if(events.begin(), events.end(),
+                [&](const ProfileEvent& e) { return e.startNs < sinceNs; }), events.end());
+        }
+    }
+
+    bool Profiler::exportChromeTrace(const std::string& path, uint64_t sinceNs) {
+        std::ofstream ofs(path);
+        if (!ofs.is_open()) {
+            std::cerr << "Failed to open file for writing: " << path << "\n";
+            return false;
+        }
+
+        std::vector<ProfileThreadEvents> threads;
+        snapshot(sinceNs, threads);
+        ofs << "{\"traceEvents\":[\n";
+        bool first = true;
+        char buf[128];
+        for (const auto& thread : threads) {
+            if (thread.events.empty()) continue;
+            ofs << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.threadId
+                << ",\"args\":{\"name\":\"";
+            writeEscaped(ofs, thread.threadName.c_str());
+            ofs << "\"}}";
+            first = false;
+            for (const auto& e : thread.events) {
+                ofs << ",\n{\"name\":\"";
+                writeEscaped(ofs, e.name);
+                std::snprintf(buf, sizeof(buf), "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    thread.threadId, e.startNs / 1000.0, (e.endNs - e.startNs) / 1000.0);
+                ofs << buf;
+            }
+        }
+        ofs << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return ofs.good();
+    }
+
+    void Profiler::renderImGui() {
+        ImGui::Begin("CPU Profiler");
+        bool on = isEnabled();
+        if (ImGui::Checkbox("Enabled", &on)) setEnabled(on);
+        ImGui::SameLine();
+        ImGui::Checkbox("Pause", &flamePaused);
+        ImGui::SliderInt("Frames", &flameFrames, 1, static_cast<int>(kFrameHistory) - 1);
+        ImGui::InputText("##TracePath", exportPath, sizeof(exportPath));
+        ImGui::SameLine();
+        if (ImGui::Button("Export Chrome Trace")) {
+            if (exportChromeTrace(exportPath, frameStartNs(flameFrames))) {
+                std::cout << "Profile trace written to " << exportPath << "\n";
+            }
+        }
+
+        if (!flamePaused) {
+            flameStart = frameStartNs(flameFrames);
+            flameEnd = frameStartNs(0);
+            if (on && flameStart) snapshot(flameStart, flameEvents);
+            else flameEvents.clear();
+        }
+
+        // Flame view: one lane per thread, nested zones stacked downwards
+        ImDrawList* draw = ImGui::GetWindowDrawList();
+        const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+        float width = ImGui::GetContentRegionAvail().x;
+        double span = flameEnd > flameStart ? static_cast<double>(flameEnd - flameStart) : 1.0;
+        for (const auto& thread : flameEvents) {
+            if (thread.events.empty()) continue;
+            uint32_t maxDepth = 0;
+            for (const auto& e : thread.events) maxDepth = std::max(maxDepth, e.depth);
+
+            ImGui::TextUnformatted(thread.threadName.c_str());
+            ImVec2 origin = ImGui::GetCursorScreenPos();
+            ImGui::InvisibleButton(thread.threadName.c_str(), ImVec2(std::max(1.0f, width), rowHeight * (maxDepth + 1)));
+            bool hovered = ImGui::IsItemHovered();
+            ImVec2 mouse = ImGui::GetIO().MousePos;
+
+            for (const auto& e : thread.events) {
+                if (e.endNs < flameStart || e.startNs > flameEnd) continue;
+                float x0 = origin.x + static_cast<float>((e.startNs - flameStart) / span) * width;
+                float x1 = origin.x + static_cast<float>((std::min(e.endNs, flameEnd) - flameStart) / span) * width;
+                float y0 = origin.y + e.depth * rowHeight;
+                x1 = std::max(x1, x0 + 1.0f);
+                ImU32 color = ImColor::HSV((reinterpret_cast<uintptr_t>(e.name) % 97) / 97.0f, 0.5f, 0.8f);
+                draw->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y0 + rowHeight - 1.0f), color);
+                if (x1 - x0 > 30.0f) {
+                    draw->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y0 + rowHeight), true);
+                    draw->AddText(ImVec2(x0 + 2.0f, y0 + 2.0f), IM_COL32_BLACK, e.name);
+                    draw->PopClipRect();
+                }
+                if (hovered && mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < y0 + rowHeight) {
+                    ImGui::SetTooltip("%s\n%.3f ms", e.name, (e.endNs - e.startNs) / 1.0e6);
+                }
+            }
+        }
+        ImGui::End();
+    }
+
+    ProfileScope::ProfileScope(const char* zoneName)
+        : name(zoneName)
+    {
+        if (!Profiler::isEnabled()) return;
+        active = true;
+        ++localDepth;
+        startNs = Profiler::nowNs();
+    }
+
+    ProfileScope::~ProfileScope() {
+        if (!active) return;
+        --localDepth;
+        ProfileEvent event;
+        event.name = name;
+        event.startNs = startNs;
+        event.endNs = Profiler::nowNs();
+        event.depth = localDepth;
+        Profiler::record(event);
+    }
+}
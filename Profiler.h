@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hierarchical CPU zones. Each thread records into its own ring buffer without
+// locks; when profiling is off a zone costs one relaxed atomic load.
+#define SS_PROFILE_CONCAT_INNER(a, b) a##b
+#define SS_PROFILE_CONCAT(a, b) SS_PROFILE_CONCAT_INNER(a, b)
+#define SS_PROFILE_SCOPE(name) ::SS::ProfileScope SS_PROFILE_CONCAT(ssProfileScope, __LINE__)(name)
+
+namespace SS
+{
+    struct ProfileEvent {
+        const char* name = nullptr; // must be a string literal or otherwise outlive the capture
+        uint64_t startNs = 0;
+        uint64_t endNs = 0;
+        uint32_t depth = 0;
+    };
+
+    struct ProfileThreadEvents {
+        uint32_t threadId = 0;
+        std::string threadName;
+        std::vector<ProfileEvent> events;
+    };
+
+    class Profiler {
+    public:
+        static constexpr size_t kEventsPerThread = 1 << 16;
+        static constexpr size_t kFrameHistory = 256;
+
+        static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+        static void setEnabled(bool on);
+
+        static uint64_t nowNs();
+        static void setThreadName(const char* name);
+        static void record(const ProfileEvent& event);
+
+        // Marks the start of a new frame on the calling (main) thread.
+        static void markFrame();
+
+        // Copies the events of every thread that started at or after `sinceNs`
+        // into `out`, one entry per registered thread (possibly without events).
+        // Reuses the storage already in `out`.
+        static void snapshot(uint64_t sinceNs, std::vector<ProfileThreadEvents>& out);
+        // Start time of the frame `framesAgo` frames back, 0 when not recorded.
+        static uint64_t frameStartNs(size_t framesAgo);
+
+        // Writes Chrome trace_event JSON, loadable in about:tracing or Perfetto.
+        static bool exportChromeTrace(const std::string& path, uint64_t sinceNs = 0);
+
+        static void renderImGui();
+
+    private:
+        static std::atomic<bool> enabled;
+    };
+
+    class ProfileScope {
+    public:
+        explicit ProfileScope(const char* name);
+        ~ProfileScope();
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        const char* name;
+        uint64_t startNs = 0;
+        bool active = false;
+    };
+}
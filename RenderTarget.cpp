@@ -0,0 +1,94 @@
+#include "RenderTarget.h"
+#include "MemoryTracker.h"
+#include <imgui.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace SS
+{
+    RenderTarget::~RenderTarget() {
+        release();
+    }
+
+    void RenderTarget::release() {
+        if (fbo) glDeleteFramebuffers(1, &fbo);
+        if (color) GpuMemory::deleteTextures(1, &color);
+        if (depth) GpuMemory::deleteRenderbuffers(1, &depth);
+        fbo = color = depth = 0;
+        allocatedWidth = allocatedHeight = 0;
+    }
+
+    bool RenderTarget::ensureSize(int width, int height) {
+        if (width <= 0 || height <= 0) return false;
+        if (fbo && width == allocatedWidth && height == allocatedHeight) return true;
+
+        release();
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+        glGenTextures(1, &color);
+        glBindTexture(GL_TEXTURE_2D, color);
+        GpuMemory::texImage2D(color, GL_TEXTURE_2D, 0, GL_RGBA8, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr,
+            MemoryTag::GpuRenderTargets);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        GpuMemory::renderbufferStorage(depth, GL_DEPTH24_STENCIL8, width, height, MemoryTag::GpuRenderTargets);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!complete) {
+            std::cerr << "Offscreen render target is incomplete (" << width << "x" << height << ")\n";
+            release();
+            return false;
+        }
+        allocatedWidth = width;
+        allocatedHeight = height;
+        return true;
+    }
+
+    void RenderTarget::bind() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    }
+
+    void RenderTarget::blitTo(GLuint dstFramebuffer, int srcWidth, int srcHeight, int dstWidth, int dstHeight) const {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dstFramebuffer);
+        glBlitFramebuffer(0, 0, srcWidth, srcHeight, 0, 0, dstWidth, dstHeight, GL_COLOR_BUFFER_BIT,
+            (srcWidth == dstWidth && srcHeight == dstHeight) ? GL_NEAREST : GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, dstFramebuffer);
+    }
+
+    void DynamicResolution::update(float frameMs) {
+        if (!enabled || frameMs <= 0.0f) return;
+        smoothedMs = smoothedMs > 0.0f ? smoothedMs + (frameMs - smoothedMs) * 0.1f : frameMs;
+
+        // Pixel count scales with scale^2, so step by the square root of the ratio,
+        // with a dead zone to stop the scale oscillating around the target.
+        float ratio = targetFrameMs / smoothedMs;
+        if (ratio < 0.95f || ratio > 1.15f) {
+            float wanted = currentScale * std::sqrt(ratio);
+            float step = std::clamp(wanted - currentScale, -0.05f, 0.02f);
+            currentScale = std::clamp(currentScale + step, minScale, maxScale);
+        }
+    }
+
+    void DynamicResolution::renderImGui(int outputWidth, int outputHeight) {
+        ImGui::Begin("Dynamic Resolution");
+        ImGui::Checkbox("Enabled", &enabled);
+        ImGui::SliderFloat("Target Frame (ms)", &targetFrameMs, 4.0f, 50.0f);
+        ImGui::SliderFloat("Min Scale", &minScale, 0.25f, 1.0f);
+        float s = scale();
+        ImGui::Text("Render scale: %.2f (%dx%d -> %dx%d)", s,
+            static_cast<int>(outputWidth * s), static_cast<int>(outputHeight * s), outputWidth, outputHeight);
+        ImGui::Text("Smoothed frame: %.2f ms", smoothedMs);
+        ImGui::End();
+    }
+}
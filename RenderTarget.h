@@ -0,0 +1,53 @@
+#pragma once
+#include <GL/glew.h>
+
+namespace SS
+{
+    // Offscreen color + depth target. Storage is only reallocated when the
+    // requested size changes, so callers can call ensureSize() every frame.
+    class RenderTarget {
+    public:
+        RenderTarget() = default;
+        ~RenderTarget();
+
+        RenderTarget(const RenderTarget&) = delete;
+        RenderTarget& operator=(const RenderTarget&) = delete;
+
+        bool ensureSize(int width, int height);
+        void bind() const;
+        // Stretches the (0,0)-(srcWidth,srcHeight) region onto `dstFramebuffer`.
+        void blitTo(GLuint dstFramebuffer, int srcWidth, int srcHeight, int dstWidth, int dstHeight) const;
+        void release();
+
+        GLuint framebuffer() const { return fbo; }
+        GLuint colorTexture() const { return color; }
+        int width() const { return allocatedWidth; }
+        int height() const { return allocatedHeight; }
+
+    private:
+        GLuint fbo = 0;
+        GLuint color = 0;
+        GLuint depth = 0;
+        int allocatedWidth = 0;
+        int allocatedHeight = 0;
+    };
+
+    // Picks a render scale that keeps the frame time near a target. The scene is
+    // drawn into a sub-rectangle of a full size target, so changing the scale
+    // never reallocates anything.
+    class DynamicResolution {
+    public:
+        bool enabled = true;
+        float targetFrameMs = 16.6f;
+        float minScale = 0.5f;
+        float maxScale = 1.0f;
+
+        void update(float frameMs);
+        float scale() const { return enabled ? currentScale : maxScale; }
+        void renderImGui(int outputWidth, int outputHeight);
+
+    private:
+        float currentScale = 1.0f;
+        float smoothedMs = 0.0f;
+    };
+}
@@ -0,0 +1,9 @@
+#include "ResourcePools.h"
+
+namespace SS
+{
+    ResourcePools& ResourcePools::Get() {
+        static ResourcePools pools;
+        return pools;
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "HandlePool.h"
+#include "ModelManager.h"
+
+namespace SS
+{
+    // Process-wide storage for models and the GL resources they own. Pools only
+    // change on the GL context thread while no update is in flight; everything
+    // else keeps handles, which survive other resources loading and unloading.
+    struct ResourcePools {
+        HandlePool<MeshGL> meshes;
+        HandlePool<TextureGL> textures;
+        HandlePool<Model> models;
+
+        static ResourcePools& Get();
+    };
+}
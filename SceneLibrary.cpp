@@ -0,0 +1,315 @@
+#include "SceneLibrary.h"
+#include "SceneManager.h"
+#include "SceneSaver.h"
+#include "Profiler.h"
+#include "Timing.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace SS
+{
+    static_assert(sizeof(SceneLibraryHeader) == 48, "SceneLibraryHeader layout is part of the file format");
+    static_assert(sizeof(SceneRecord) == 48, "SceneRecord layout is part of the file format");
+    static_assert(sizeof(PointLightRecord) == 32, "PointLightRecord layout is part of the file format");
+
+    namespace
+    {
+        uint64_t align8(uint64_t offset) {
+            return (offset + 7) & ~uint64_t(7);
+        }
+
+        int64_t residentBytes() {
+#ifdef _WIN32
+            PROCESS_MEMORY_COUNTERS counters{};
+            if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+            return static_cast<int64_t>(counters.WorkingSetSize);
+#else
+            std::ifstream statm("/proc/self/statm");
+            int64_t pages = 0, resident = 0;
+            if (!(statm >> pages >> resident)) return 0;
+            return resident * static_cast<int64_t>(sysconf(_SC_PAGESIZE));
+#endif
+        }
+    }
+
+    SceneLibraryFile::~SceneLibraryFile() {
+        close();
+    }
+
+    bool SceneLibraryFile::open(const std::string& path) {
+        SS_PROFILE_SCOPE("SceneLibraryFile::open");
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            std::cerr << "Failed to open scene library: " << path << "\n";
+            return false;
+        }
+        LARGE_INTEGER size{};
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view) {
+            if (mapping) CloseHandle(mapping);
+            CloseHandle(file);
+            std::cerr << "Failed to map scene library: " << path << "\n";
+            return false;
+        }
+        fileHandle = file;
+        mappingHandle = mapping;
+        fileSize = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Failed to open scene library: " << path << "\n";
+            return false;
+        }
+        struct stat info {};
+        void* view = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd); // the mapping keeps the file alive
+        if (view == MAP_FAILED) {
+            std::cerr << "Failed to map scene library: " << path << "\n";
+            return false;
+        }
+        fileSize = static_cast<size_t>(info.st_size);
+#endif
+        data = static_cast<const unsigned char*>(view);
+
+        if (!validate()) {
+            std::cerr << "Scene library is corrupt or from another version: " << path << "\n";
+            close();
+            return false;
+        }
+        header = reinterpret_cast<const SceneLibraryHeader*>(data);
+        records = reinterpret_cast<const SceneRecord*>(data + header->scenesOffset);
+        lights = reinterpret_cast<const PointLightRecord*>(data + header->lightsOffset);
+        strings = reinterpret_cast<const char*>(data + header->stringsOffset);
+        return true;
+    }
+
+    void SceneLibraryFile::close() {
+        if (!data) return;
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+        mappingHandle = fileHandle = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(data), fileSize);
+#endif
+        data = nullptr;
+        fileSize = 0;
+        header = nullptr;
+        records = nullptr;
+        lights = nullptr;
+        strings = nullptr;
+    }
+
+    bool SceneLibraryFile::validate() const {
+        if (fileSize < sizeof(SceneLibraryHeader)) return false;
+        const auto& h = *reinterpret_cast<const SceneLibraryHeader*>(data);
+        if (h.magic != kMagic || h.version != kVersion) return false;
+        // Offsets are 64-bit and counts 32-bit, so none of these sums overflow
+        uint64_t size = fileSize;
+        if (h.scenesOffset % 8 || h.lightsOffset % 8) return false;
+        if (h.scenesOffset > size || h.sceneCount * uint64_t(sizeof(SceneRecord)) > size - h.scenesOffset) return false;
+        if (h.lightsOffset > size || h.lightCount * uint64_t(sizeof(PointLightRecord)) > size - h.lightsOffset) return false;
+        if (h.stringsOffset > size || h.stringsSize > size - h.stringsOffset) return false;
+
+        const auto* recs = reinterpret_cast<const SceneRecord*>(data + h.scenesOffset);
+        const char* pool = reinterpret_cast<const char*>(data + h.stringsOffset);
+        auto validString = [&](SceneStringRef ref) {
+            uint64_t end = uint64_t(ref.offset) + ref.length;
+            return end < h.stringsSize && pool[end] == '\0';
+        };
+        for (uint32_t i = 0; i < h.sceneCount; ++i) {
+            const SceneRecord& r = recs[i];
+            if (!validString(r.name) || !validString(r.meshPath) || !validString(r.musicPath)) return false;
+            if (uint64_t(r.firstLight) + r.lightCount > h.lightCount) return false;
+        }
+        return true;
+    }
+
+    Scene SceneLibraryFile::scene(size_t index) const {
+        const SceneRecord& r = records[index];
+        Scene s;
+        s.name.assign(name(index));
+        s.meshPath.assign(meshPath(index));
+        s.musicPath.assign(musicPath(index));
+        s.lightPos = glm::vec3(r.lightPos[0], r.lightPos[1], r.lightPos[2]);
+        s.ambientIntensity = r.ambientIntensity;
+        s.pointLights.resize(r.lightCount);
+        for (uint32_t i = 0; i < r.lightCount; ++i) {
+            const PointLightRecord& l = lights[r.firstLight + i];
+            PointLight& p = s.pointLights[i];
+            p.position = glm::vec3(l.position[0], l.position[1], l.position[2]);
+            p.color = glm::vec3(l.color[0], l.color[1], l.color[2]);
+            p.radius = l.radius;
+            p.intensity = l.intensity;
+        }
+        return s;
+    }
+
+    void SceneLibraryFile::readAll(std::vector<Scene>& scenes) const {
+        SS_PROFILE_SCOPE("SceneLibraryFile::readAll");
+        scenes.clear();
+        scenes.reserve(size());
+        for (size_t i = 0; i < size(); ++i) scenes.push_back(scene(i));
+    }
+
+    bool SceneLibraryFile::isBinaryPath(const std::string& path) {
+        return fs::path(path).extension() == ".sslib";
+    }
+
+    std::string SceneLibraryFile::encode(const std::vector<Scene>& scenes) {
+        std::vector<SceneRecord> sceneRecords(scenes.size());
+        std::vector<PointLightRecord> lightRecords;
+        std::string pool;
+        auto addString = [&pool](const std::string& s) {
+            SceneStringRef ref{ static_cast<uint32_t>(pool.size()), static_cast<uint32_t>(s.size()) };
+            pool.append(s);
+            pool.push_back('\0');
+            return ref;
+        };
+        for (size_t i = 0; i < scenes.size(); ++i) {
+            const Scene& s = scenes[i];
+            SceneRecord& r = sceneRecords[i];
+            r.name = addString(s.name);
+            r.meshPath = addString(s.meshPath);
+            r.musicPath = addString(s.musicPath);
+            std::memcpy(r.lightPos, &s.lightPos[0], sizeof(r.lightPos));
+            r.ambientIntensity = s.ambientIntensity;
+            r.firstLight = static_cast<uint32_t>(lightRecords.size());
+            r.lightCount = static_cast<uint32_t>(s.pointLights.size());
+            for (const auto& l : s.pointLights) {
+                PointLightRecord lr;
+                std::memcpy(lr.position, &l.position[0], sizeof(lr.position));
+                std::memcpy(lr.color, &l.color[0], sizeof(lr.color));
+                lr.radius = l.radius;
+                lr.intensity = l.intensity;
+                lightRecords.push_back(lr);
+            }
+        }
+
+        SceneLibraryHeader h;
+        h.magic = kMagic;
+        h.version = kVersion;
+        h.sceneCount = static_cast<uint32_t>(sceneRecords.size());
+        h.lightCount = static_cast<uint32_t>(lightRecords.size());
+        h.scenesOffset = align8(sizeof(SceneLibraryHeader));
+        h.lightsOffset = align8(h.scenesOffset + sceneRecords.size() * sizeof(SceneRecord));
+        h.stringsOffset = align8(h.lightsOffset + lightRecords.size() * sizeof(PointLightRecord));
+        h.stringsSize = pool.size();
+
+        std::string out(static_cast<size_t>(h.stringsOffset + h.stringsSize), '\0');
+        std::memcpy(&out[0], &h, sizeof(h));
+        if (!sceneRecords.empty()) {
+            std::memcpy(&out[h.scenesOffset], sceneRecords.data(), sceneRecords.size() * sizeof(SceneRecord));
+        }
+        if (!lightRecords.empty()) {
+            std::memcpy(&out[h.lightsOffset], lightRecords.data(), lightRecords.size() * sizeof(PointLightRecord));
+        }
+        if (!pool.empty()) std::memcpy(&out[h.stringsOffset], pool.data(), pool.size());
+        return out;
+    }
+
+    bool SceneLibraryFile::convert(const std::string& jsonPath, const std::string& binaryPath) {
+        std::ifstream ifs(jsonPath);
+        if (!ifs.is_open()) {
+            std::cerr << "Failed to open file for reading: " << jsonPath << "\n";
+            return false;
+        }
+        std::vector<Scene> scenes;
+        if (!SceneManager::ParseJson(ifs, scenes)) {
+            std::cerr << "Failed to parse " << jsonPath << "\n";
+            return false;
+        }
+        if (!SceneSaver::writeAtomically(binaryPath, encode(scenes))) return false;
+        std::cout << "Converted " << scenes.size() << " scenes to " << binaryPath << "\n";
+        return true;
+    }
+
+    void SceneLibraryFile::runBenchmark(size_t count) {
+        std::error_code ec;
+        fs::path dir = fs::temp_directory_path(ec);
+        std::string jsonPath = (dir / "ss_scene_benchmark.json").string();
+        std::string binaryPath = (dir / "ss_scene_benchmark.sslib").string();
+        {
+            std::vector<Scene> generated(count);
+            char buf[64];
+            for (size_t i = 0; i < count; ++i) {
+                Scene& s = generated[i];
+                std::snprintf(buf, sizeof(buf), "Scene %06zu", i);
+                s.name = buf;
+                std::snprintf(buf, sizeof(buf), "assets/models/Model%03zu.glb", i % 97);
+                s.meshPath = buf;
+                std::snprintf(buf, sizeof(buf), "assets/musics/Track%02zu.ogg", i % 31);
+                s.musicPath = buf;
+                s.lightPos = glm::vec3(static_cast<float>(i % 7), 3.0f, 2.0f);
+                s.pointLights.resize(i % 3);
+            }
+            if (!SceneSaver::writeAtomically(jsonPath, SceneSaver::serialize(generated))
+                || !SceneSaver::writeAtomically(binaryPath, encode(generated))) {
+                return;
+            }
+        }
+        std::printf("Scene library benchmark, %zu scenes: JSON %.1f KB, binary %.1f KB\n", count,
+            fs::file_size(jsonPath, ec) / 1024.0, fs::file_size(binaryPath, ec) / 1024.0);
+
+        // Binary first, so heap the JSON path leaves behind does not hide its growth
+        auto report = [](const char* label, double ms, int64_t rss, size_t scenes) {
+            std::printf("  %-28s %9.2f ms  %+9.1f MB RSS  %zu scenes\n", label, ms, rss / (1024.0 * 1024.0), scenes);
+        };
+        {
+            int64_t before = residentBytes();
+            auto start = std::chrono::steady_clock::now();
+            SceneLibraryFile file;
+            size_t chars = 0;
+            if (file.open(binaryPath)) {
+                for (size_t i = 0; i < file.size(); ++i) chars += file.name(i).size();
+            }
+            report("binary, mapped in place", elapsedMs(start), residentBytes() - before, file.size());
+            std::printf("  %-28s %zu bytes of names read from the mapping\n", "", chars);
+        }
+        {
+            int64_t before = residentBytes();
+            auto start = std::chrono::steady_clock::now();
+            std::vector<Scene> scenes;
+            SceneLibraryFile file;
+            if (file.open(binaryPath)) file.readAll(scenes);
+            report("binary, copied to Scenes", elapsedMs(start), residentBytes() - before, scenes.size());
+        }
+        {
+            int64_t before = residentBytes();
+            auto start = std::chrono::steady_clock::now();
+            std::vector<Scene> scenes;
+            std::ifstream ifs(jsonPath);
+            SceneManager::ParseJson(ifs, scenes);
+            report("JSON, parsed to Scenes", elapsedMs(start), residentBytes() - before, scenes.size());
+        }
+        fs::remove(jsonPath, ec);
+        fs::remove(binaryPath, ec);
+    }
+}
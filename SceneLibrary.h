@@ -0,0 +1,100 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace SS
+{
+    struct Scene;
+
+    // On-disk layout of a binary scene library (*.sslib), little-endian:
+    // header, fixed-size scene records, point light records, then a pool of
+    // NUL-terminated strings the records point into by offset. Sections start
+    // on 8-byte boundaries so the records can be read in place from a mapping.
+    struct SceneLibraryHeader {
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t sceneCount = 0;
+        uint32_t lightCount = 0;
+        uint64_t scenesOffset = 0;
+        uint64_t lightsOffset = 0;
+        uint64_t stringsOffset = 0;
+        uint64_t stringsSize = 0;
+    };
+
+    struct SceneStringRef {
+        uint32_t offset = 0; // into the string pool
+        uint32_t length = 0; // without the terminating NUL
+    };
+
+    struct SceneRecord {
+        SceneStringRef name;
+        SceneStringRef meshPath;
+        SceneStringRef musicPath;
+        float lightPos[3] = {};
+        float ambientIntensity = 0.0f;
+        uint32_t firstLight = 0;
+        uint32_t lightCount = 0;
+    };
+
+    struct PointLightRecord {
+        float position[3] = {};
+        float color[3] = {};
+        float radius = 0.0f;
+        float intensity = 0.0f;
+    };
+
+    // Read-only view of a memory-mapped scene library. Opening maps the file
+    // and checks every record against its bounds; the strings and records are
+    // then read straight from the mapping, and only scene()/readAll() copy.
+    class SceneLibraryFile {
+    public:
+        static constexpr uint32_t kMagic = 0x424C5353; // "SSLB"
+        static constexpr uint32_t kVersion = 1;
+
+        SceneLibraryFile() = default;
+        ~SceneLibraryFile();
+
+        SceneLibraryFile(const SceneLibraryFile&) = delete;
+        SceneLibraryFile& operator=(const SceneLibraryFile&) = delete;
+
+        bool open(const std::string& path);
+        void close();
+        bool isOpen() const { return data != nullptr; }
+
+        size_t size() const { return header ? header->sceneCount : 0; }
+        const SceneRecord& record(size_t index) const { return records[index]; }
+        // Views into the mapping; data() is NUL-terminated.
+        std::string_view name(size_t index) const { return string(records[index].name); }
+        std::string_view meshPath(size_t index) const { return string(records[index].meshPath); }
+        std::string_view musicPath(size_t index) const { return string(records[index].musicPath); }
+
+        Scene scene(size_t index) const;
+        void readAll(std::vector<Scene>& scenes) const;
+
+        static bool isBinaryPath(const std::string& path);
+        static std::string encode(const std::vector<Scene>& scenes);
+        // Rewrites a scenes.json library in the binary format.
+        static bool convert(const std::string& jsonPath, const std::string& binaryPath);
+        // Times startup from `count` generated scenes through the JSON and the
+        // binary path and reports resident memory for each.
+        static void runBenchmark(size_t count);
+
+    private:
+        const unsigned char* data = nullptr;
+        size_t fileSize = 0;
+        const SceneLibraryHeader* header = nullptr;
+        const SceneRecord* records = nullptr;
+        const PointLightRecord* lights = nullptr;
+        const char* strings = nullptr;
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+
+        std::string_view string(SceneStringRef ref) const { return std::string_view(strings + ref.offset, ref.length); }
+        bool validate() const;
+    };
+}
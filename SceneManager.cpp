@@ -1,52 +1,262 @@
 #include "SceneManager.h"
+#include "Profiler.h"
+#include "SceneLibrary.h"
+#include "Timing.h"
 #include <imgui.h>
 #include <iostream>
 #include <filesystem>
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
 
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
 namespace SS
 {
-    SceneManager::SceneManager() {
-        meshFiles.clear();
-        try {
-            for (const auto& entry : fs::directory_iterator("assets/models")) {
-                if (entry.path().extension() == ".glb") {
-                    meshFiles.push_back(entry.path().string());
-                }
+    namespace
+    {
+        void assetTooltip(const AssetInfo& asset) {
+            if (!ImGui::BeginItemTooltip()) return;
+            ImGui::Text("%.1f KB, hash %016llx", asset.size / 1024.0, static_cast<unsigned long long>(asset.hash));
+            if (asset.triangles >= 0) ImGui::Text("%lld triangles", static_cast<long long>(asset.triangles));
+            if (asset.durationSeconds >= 0.0) {
+                int seconds = static_cast<int>(asset.durationSeconds + 0.5);
+                ImGui::Text("%d:%02d", seconds / 60, seconds % 60);
             }
+            ImGui::EndTooltip();
         }
-        catch (...) {
-            std::cerr << "Warning: Cannot scan assets/models folder\n";
+
+        // The binary library wins when both exist, see --convert-scenes
+        std::string defaultLibraryPath() {
+            std::error_code ec;
+            return fs::exists("scenes.sslib", ec) ? "scenes.sslib" : "scenes.json";
         }
 
-        musicFiles.clear();
-        try {
-            for (const auto& entry : fs::directory_iterator("assets/musics")) {
-                if (entry.path().extension() == ".wav" || entry.path().extension() == ".ogg" || entry.path().extension() == ".mp3") {
-                    musicFiles.push_back(entry.path().string());
+        std::string foldCase(const char* text) {
+            std::string result(text);
+            for (char& c : result) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            return result;
+        }
+
+        // nlohmann SAX handler that builds Scene records while the document is
+        // read. A record with a field of the wrong type or shape is dropped on
+        // its own; a syntax error stops the read but keeps the records before it.
+        class SceneJsonReader {
+        public:
+            explicit SceneJsonReader(std::vector<Scene>& scenes) : scenes(scenes) {}
+
+            int skippedRecords = 0;
+            std::string error;
+
+            bool null() { return scalar(Value::Null); }
+            bool boolean(bool) { return scalar(Value::Other); }
+            bool number_integer(json::number_integer_t v) { return number(static_cast<float>(v)); }
+            bool number_unsigned(json::number_unsigned_t v) { return number(static_cast<float>(v)); }
+            bool number_float(json::number_float_t v, const json::string_t&) { return number(static_cast<float>(v)); }
+            bool string(json::string_t& v) {
+                if (top() == Context::Record) {
+                    std::string* field = currentKey == "name" ? &record.name
+                        : currentKey == "meshPath" ? &record.meshPath
+                        : currentKey == "musicPath" ? &record.musicPath : nullptr;
+                    if (field) {
+                        *field = std::move(v);
+                        return true;
+                    }
                 }
+                return scalar(Value::Other);
             }
-        }
-        catch (...) {
-            std::cerr << "Warning: Cannot scan assets/musics folder\n";
-        }
+            bool binary(json::binary_t&) { return scalar(Value::Other); }
+
+            bool start_object(std::size_t) {
+                switch (top()) {
+                case Context::None:
+                    stack.push_back(Context::Root);
+                    return true;
+                case Context::Scenes:
+                    record = Scene{};
+                    recordValid = true;
+                    stack.push_back(Context::Record);
+                    return true;
+                case Context::Lights:
+                    light = PointLight{};
+                    stack.push_back(Context::Light);
+                    return true;
+                case Context::Record:
+                case Context::Light:
+                    if (isKnownKey()) recordValid = false;
+                    break;
+                case Context::LightPos:
+                case Context::LightVector:
+                    recordValid = false;
+                    break;
+                default:
+                    break;
+                }
+                stack.push_back(Context::Skip);
+                return true;
+            }
+
+            bool start_array(std::size_t) {
+                Context next = Context::Skip;
+                switch (top()) {
+                case Context::Root:
+                    if (currentKey == "scenes") next = Context::Scenes;
+                    break;
+                case Context::Scenes:
+                    ++skippedRecords;
+                    break;
+                case Context::Record:
+                    if (currentKey == "lightPos") next = Context::LightPos;
+                    else if (currentKey == "pointLights") next = Context::Lights;
+                    else if (isKnownKey()) recordValid = false;
+                    break;
+                case Context::Light:
+                    if (currentKey == "position" || currentKey == "color") {
+                        target = currentKey == "position" ? &light.position : &light.color;
+                        next = Context::LightVector;
+                    }
+                    else if (isKnownKey()) recordValid = false;
+                    break;
+                case Context::LightPos:
+                case Context::LightVector:
+                case Context::Lights:
+                    recordValid = false;
+                    break;
+                default:
+                    break;
+                }
+                if (next == Context::LightPos) target = &record.lightPos;
+                if (next == Context::LightPos || next == Context::LightVector) components = 0;
+                stack.push_back(next);
+                return true;
+            }
+
+            bool end_object() { return end(); }
+            bool end_array() { return end(); }
+
+            bool key(json::string_t& k) {
+                currentKey.swap(k);
+                return true;
+            }
+
+            bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) {
+                error = e.what();
+                return false;
+            }
+
+        private:
+            enum class Context { None, Root, Scenes, Record, LightPos, Lights, Light, LightVector, Skip };
+            enum class Value { Null, Number, Other };
+
+            std::vector<Scene>& scenes;
+            std::vector<Context> stack;
+            std::string currentKey;
+            Scene record;
+            PointLight light;
+            bool recordValid = true;
+            glm::vec3* target = nullptr; // array being read into
+            int components = 0;
+
+            Context top() const { return stack.empty() ? Context::None : stack.back(); }
+
+            bool isKnownKey() const {
+                if (top() == Context::Light) {
+                    return currentKey == "position" || currentKey == "color" || currentKey == "radius" || currentKey == "intensity";
+                }
+                return currentKey == "name" || currentKey == "meshPath" || currentKey == "musicPath" || currentKey == "lightPos"
+                    || currentKey == "ambientIntensity" || currentKey == "pointLights";
+            }
+
+            bool number(float v) {
+                switch (top()) {
+                case Context::Record:
+                    if (currentKey == "ambientIntensity") record.ambientIntensity = v;
+                    else return scalar(Value::Number);
+                    return true;
+                case Context::Light:
+                    if (currentKey == "radius") light.radius = v;
+                    else if (currentKey == "intensity") light.intensity = v;
+                    else return scalar(Value::Number);
+                    return true;
+                case Context::LightPos:
+                case Context::LightVector:
+                    if (components < 3) (*target)[components] = v;
+                    ++components;
+                    return true;
+                default:
+                    return scalar(Value::Number);
+                }
+            }
+
+            // A value nobody above consumed
+            bool scalar(Value value) {
+                switch (top()) {
+                case Context::Scenes:
+                    ++skippedRecords;
+                    break;
+                case Context::Record:
+                case Context::Light:
+                    // null leaves a known field at its default
+                    if (value != Value::Null && isKnownKey()) recordValid = false;
+                    break;
+                case Context::LightPos:
+                case Context::LightVector:
+                case Context::Lights:
+                    recordValid = false;
+                    break;
+                default:
+                    break;
+                }
+                return true;
+            }
+
+            bool end() {
+                Context closed = top();
+                stack.pop_back();
+                switch (closed) {
+                case Context::Record:
+                    if (recordValid) scenes.push_back(std::move(record));
+                    else ++skippedRecords;
+                    break;
+                case Context::Light:
+                    record.pointLights.push_back(light);
+                    break;
+                case Context::LightPos:
+                case Context::LightVector:
+                    if (components != 3) recordValid = false;
+                    target = nullptr;
+                    break;
+                default:
+                    break;
+                }
+                return true;
+            }
+        };
+    }
 
-        LoadFromFile("scenes.json");
+    SceneManager::SceneManager() {
+        // meshFiles and musicFiles fill in from the asset database, see updateAssets
+        assets = std::make_unique<AssetDatabase>("assets/models", "assets/musics", "asset_index.json");
+        libraryPath = defaultLibraryPath();
+        LoadFromFile(libraryPath);
         sceneNameBuf[0] = '\0';
     }
 
-    void SceneManager::renderImGui(
-        std::function<void(const std::string&)> onMeshSelected,
-        std::function<void(const std::string&)> onMusicSelected,
-        std::function<void(const Scene&)> onSceneLoaded,
+    SceneManager::SceneManager(Detached) {
+    }
+
+    SceneEditorEvents SceneManager::renderImGui(
         glm::vec3& currentLightPos,
-        float& currentAmbient) {
+        float& currentAmbient,
+        std::vector<PointLight>& currentPointLights) {
+        SS_PROFILE_SCOPE("SceneManager::renderImGui");
         ImGui::Begin("Scene Editor");
+        SceneEditorEvents events;
+        updateAssets(events);
 
         // --- MESH SELECTION ---
         ImGui::Text("Select Mesh (.glb):");
@@ -55,10 +265,10 @@ namespace SS
                 bool sel = (selectedMesh == i);
                 if (ImGui::Selectable(meshFiles[i].c_str(), sel)) {
                     selectedMesh = i;
-                    if (onMeshSelected) {
-                        onMeshSelected(meshFiles[i]);
-                    }
+                    wantedMesh = meshFiles[i];
+                    events.meshSelected = i;
                 }
+                assetTooltip(meshAssets[i]);
                 if (sel) ImGui::SetItemDefaultFocus();
             }
             ImGui::EndCombo();
@@ -72,160 +282,377 @@ namespace SS
                 bool sel = (selectedMusic == i);
                 if (ImGui::Selectable(musicFiles[i].c_str(), sel)) {
                     selectedMusic = i;
-                    if (onMusicSelected) {
-                        onMusicSelected(musicFiles[i]);
-                    }
+                    wantedMusic = musicFiles[i];
+                    events.musicSelected = i;
                 }
+                assetTooltip(musicAssets[i]);
                 if (sel) ImGui::SetItemDefaultFocus();
             }
             ImGui::EndCombo();
         }
+        if (assets) {
+            ImGui::TextDisabled("%zu models, %zu tracks (%s, last scan %.1f ms)",
+                meshFiles.size(), musicFiles.size(), assets->watcherName(), assets->lastScanMs());
+        }
 
 
         // --- NAME AND SAVE ---
         ImGui::InputText("Scene Name", sceneNameBuf, IM_ARRAYSIZE(sceneNameBuf));
-        if (ImGui::Button("Save Scene") && sceneNameBuf[0] != '\0') {
+        if (ImGui::Button("Save Scene") && sceneNameBuf[0] != '\0' && !meshFiles.empty() && !musicFiles.empty()) {
             Scene newScene = {
                 sceneNameBuf,
                 meshFiles[selectedMesh],
                 musicFiles[selectedMusic],
                 currentLightPos,
-                currentAmbient
+                currentAmbient,
+                currentPointLights
             };
             scenes.push_back(newScene);
-            SaveToFile("scenes.json");
+            saver.append(scenes.back());
+            saver.request(libraryPath);
+            scenesEdited();
             sceneNameBuf[0] = '\0';
         }
 
         ImGui::Separator();
         ImGui::Text("Saved Scenes:");
+        SceneSaveStats saveStats = saver.stats();
+        if (saveStats.pending) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(saving...)");
+        }
+        else if (saveStats.writes > 0) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(written in %.1f ms, %.0f ms after the edit)", saveStats.lastWriteMs, saveStats.lastLatencyMs);
+        }
+        if (saveStats.failures > 0) {
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%d saves failed", saveStats.failures);
+        }
 
         // --- SCENE LIST ---
-        for (int i = 0; i < scenes.size(); ++i) {
-            ImGui::PushID(i);
-
-            float fullWidth = ImGui::GetContentRegionAvail().x;
-            float buttonWidth = 110.0f; // width for each button approx
-            float spacing = 5.0f;
-            float buttonsTotalWidth = (buttonWidth + spacing) * 2; // Delete + Save buttons
+        ImGui::SetNextItemWidth(-1.0f);
+        bool searchEdited = ImGui::InputTextWithHint("##SceneSearch", "Search scenes", searchBuf, IM_ARRAYSIZE(searchBuf));
+        if (searchEdited || searchIndexDirty) updateSearch();
+        bool filtered = searchBuf[0] != '\0';
+        int rowCount = filtered ? static_cast<int>(searchResults.size()) : static_cast<int>(scenes.size());
+        if (filtered) ImGui::TextDisabled("%d of %zu scenes", rowCount, scenes.size());
+
+        // Rows share one height so the clipper can skip everything off screen
+        float thumbnailSize = thumbnailProvider ? ImGui::GetFrameHeight() * 2.0f : 0.0f;
+        int deletedScene = -1;
+        ImGui::BeginChild("##SceneList");
+        if (pendingListScroll >= 0.0f) {
+            ImGui::SetScrollY(pendingListScroll);
+            pendingListScroll = -1.0f;
+        }
+        ImGuiListClipper clipper;
+        clipper.Begin(rowCount);
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                int i = filtered ? searchResults[row] : row;
+                ImGui::PushID(i);
+
+                float fullWidth = ImGui::GetContentRegionAvail().x;
+                float buttonWidth = 110.0f; // width for each button approx
+                float spacing = 5.0f;
+                float buttonsTotalWidth = (buttonWidth + spacing) * 2; // Delete + Save buttons
+
+                ImGui::BeginGroup();
+                float thumbnailWidth = 0.0f;
+                if (thumbnailProvider) {
+                    unsigned int thumbnail = thumbnailProvider(scenes[i]);
+                    if (thumbnail) ImGui::Image(static_cast<ImTextureID>(thumbnail), ImVec2(thumbnailSize, thumbnailSize));
+                    else ImGui::Dummy(ImVec2(thumbnailSize, thumbnailSize));
+                    ImGui::SameLine();
+                    thumbnailWidth = thumbnailSize + ImGui::GetStyle().ItemSpacing.x;
+                }
+                if (ImGui::Selectable(scenes[i].name.c_str(), selectedScene == i, 0, ImVec2(fullWidth - buttonsTotalWidth - thumbnailWidth, 0))) {
+                    selectedScene = i;
+                    SelectAssets(scenes[i]);
+                    events.sceneLoaded = i;
+                }
 
-            bool deleted = false;
+                ImGui::SameLine();
+                if (ImGui::Button("Save")) {
+                    if (!meshFiles.empty()) scenes[i].meshPath = meshFiles[selectedMesh];
+                    if (!musicFiles.empty()) scenes[i].musicPath = musicFiles[selectedMusic];
+                    scenes[i].lightPos = currentLightPos;
+                    scenes[i].ambientIntensity = currentAmbient;
+                    scenes[i].pointLights = currentPointLights;
+
+                    saver.replace(i, scenes[i]);
+                    saver.request(libraryPath);
+                    updateMemoryCharge();
+                }
 
-            ImGui::BeginGroup();
-            if (ImGui::Selectable(scenes[i].name.c_str(), selectedScene == i, 0, ImVec2(fullWidth - buttonsTotalWidth, 0))) {
-                selectedScene = i;
+                ImGui::SameLine();
+                if (ImGui::Button("Delete")) deletedScene = i;
 
-                auto normalize = [](const std::string& path) -> std::string {
-                    std::string result = path;
-                    std::replace(result.begin(), result.end(), '\\', '/');
-                    return result;
-                    };
+                ImGui::EndGroup();
+                ImGui::PopID();
+            }
+        }
+        ImGui::EndChild();
+
+        if (deletedScene >= 0) {
+            scenes.erase(scenes.begin() + deletedScene);
+            if (selectedScene == deletedScene) selectedScene = -1;
+            else if (selectedScene > deletedScene) --selectedScene;
+            if (events.sceneLoaded == deletedScene) events.sceneLoaded = -1;
+            else if (events.sceneLoaded > deletedScene) --events.sceneLoaded;
+            saver.erase(deletedScene);
+            saver.request(libraryPath);
+            scenesEdited();
+        }
 
-                std::string sceneMesh = normalize(scenes[i].meshPath);
-                std::string sceneMusic = normalize(scenes[i].musicPath);
+        ImGui::End();
+        return events;
+    }
 
-                for (int m = 0; m < meshFiles.size(); ++m) {
-                    if (normalize(meshFiles[m]) == sceneMesh) {
-                        selectedMesh = m;
-                        break;
-                    }
-                }
+    void SceneManager::SaveToFile(const std::string& path) const {
+        SS_PROFILE_SCOPE("SceneManager::SaveToFile");
+        SceneSaver::writeAtomically(path, SceneSaver::encode(path, scenes));
+    }
 
-                for (int m = 0; m < musicFiles.size(); ++m) {
-                    if (normalize(musicFiles[m]) == sceneMusic) {
-                        selectedMusic = m;
-                        break;
-                    }
-                }
 
-                if (onSceneLoaded)
-                    onSceneLoaded(scenes[i]);
-            }
+    void SceneManager::LoadFromFile(const std::string& path) {
+        SS_PROFILE_SCOPE("SceneManager::LoadFromFile");
+        std::error_code ec;
+        if (!fs::exists(path, ec)) {
+            scenes = {
+                { "The Dark Knight", "assets/models/Batman.glb", "assets/musics/Somthing.ogg", glm::vec3(3,3,3), 0.5f, {} },
+                { "Man of Tomorrow", "assets/models/Superman.glb", "assets/musics/Punkrocker.ogg", glm::vec3(2,2,2), 0.6f, {} },
+                { "Heisenburg", "assets/models/Walter.glb", "assets/musics/BreakBad.ogg", glm::vec3(1,1,1), 0.4f, {} }
+            };
+            SaveToFile(path);
+            OnScenesChanged();
+            return;
+        }
+        ReadLibrary(path, scenes);
+        OnScenesChanged();
+    }
 
-            ImGui::SameLine();
-            if (ImGui::Button("Save")) {
-                scenes[i].meshPath = meshFiles[selectedMesh];
-                scenes[i].musicPath = musicFiles[selectedMusic];
-                scenes[i].lightPos = currentLightPos;
-                scenes[i].ambientIntensity = currentAmbient;
+    bool SceneManager::ReadLibrary(const std::string& path, std::vector<Scene>& scenes) {
+        if (SceneLibraryFile::isBinaryPath(path)) {
+            SceneLibraryFile library;
+            if (!library.open(path)) return false;
+            library.readAll(scenes);
+            return true;
+        }
+        // Read in 64 KB chunks; scenes are built as the stream goes by
+        std::vector<char> chunk(64 * 1024);
+        std::ifstream ifs;
+        ifs.rdbuf()->pubsetbuf(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        ifs.open(path, std::ios::binary);
+        int skipped = 0;
+        bool ok = ParseJson(ifs, scenes, &skipped);
+        if (!ok) std::cerr << "Failed to parse " << path << ", kept the " << scenes.size() << " scenes before the error\n";
+        if (skipped > 0) std::cerr << "Skipped " << skipped << " malformed scene records in " << path << "\n";
+        return ok;
+    }
 
-                SaveToFile("scenes.json");
-            }
+    bool SceneManager::ParseJson(std::istream& in, std::vector<Scene>& scenes, int* skippedRecords) {
+        SS_PROFILE_SCOPE("SceneManager::ParseJson");
+        scenes.clear();
+        SceneJsonReader reader(scenes);
+        bool ok = json::sax_parse(in, &reader);
+        if (!ok) std::cerr << "Scene library: " << reader.error << "\n";
+        if (skippedRecords) *skippedRecords = reader.skippedRecords;
+        return ok;
+    }
 
-            ImGui::SameLine();
-            if (ImGui::Button("Delete")) {
-                scenes.erase(scenes.begin() + i);
-                SaveToFile("scenes.json");
-                deleted = true;
-            }
+    void SceneManager::OnScenesChanged() {
+        saver.assign(scenes);
+        scenesEdited();
+    }
 
-            ImGui::EndGroup();
-            ImGui::PopID();
+    void SceneManager::scenesEdited() {
+        updateMemoryCharge();
+        searchIndexDirty = true;
+    }
 
-            if (deleted) break;
-        }
+    std::string SceneManager::CanonicalPath(const std::string& path) {
+        std::string result = path;
+        std::replace(result.begin(), result.end(), '\\', '/');
+        return result;
+    }
 
-        ImGui::End();
+    void SceneManager::SelectAssets(const Scene& scene) {
+        wantedMesh = scene.meshPath;
+        wantedMusic = scene.musicPath;
+        resolveSelection();
     }
 
-    void SceneManager::SaveToFile(const std::string& path) const {
-        json j;
-        for (const auto& s : scenes) {
-            j["scenes"].push_back({
-                { "name", s.name },
-                { "meshPath", s.meshPath },
-                { "musicPath", s.musicPath },
-                { "lightPos", { s.lightPos.x, s.lightPos.y, s.lightPos.z } },
-                { "ambientIntensity", s.ambientIntensity }
-                });
+    void SceneManager::updateAssets(SceneEditorEvents& events) {
+        std::vector<AssetInfo> models, music;
+        if (!assets || !assets->takeUpdate(models, music)) return;
+        SS_PROFILE_SCOPE("SceneManager::updateAssets");
+        for (const AssetInfo& asset : models) {
+            int index = FindMeshIndex(asset.path);
+            if (index >= 0 && meshAssets[index].hash != asset.hash) events.modelsChanged.push_back(asset.path);
         }
+        meshAssets.swap(models);
+        musicAssets.swap(music);
 
-        std::ofstream ofs(path);
-        if (ofs.is_open()) {
-            ofs << j.dump(4);
-            ofs.close();
+        meshFiles.clear();
+        meshLookup.clear();
+        for (const AssetInfo& asset : meshAssets) {
+            meshLookup.emplace(CanonicalPath(asset.path), static_cast<int>(meshFiles.size()));
+            meshFiles.push_back(asset.path);
         }
-        else {
-            std::cerr << "Failed to open file for writing: " << path << "\n";
+        musicFiles.clear();
+        musicLookup.clear();
+        for (const AssetInfo& asset : musicAssets) {
+            musicLookup.emplace(CanonicalPath(asset.path), static_cast<int>(musicFiles.size()));
+            musicFiles.push_back(asset.path);
         }
+        resolveSelection();
     }
 
+    void SceneManager::resolveSelection() {
+        int mesh = FindMeshIndex(wantedMesh);
+        if (mesh >= 0) selectedMesh = mesh;
+        else if (selectedMesh >= static_cast<int>(meshFiles.size())) selectedMesh = 0;
+        int music = FindMusicIndex(wantedMusic);
+        if (music >= 0) selectedMusic = music;
+        else if (selectedMusic >= static_cast<int>(musicFiles.size())) selectedMusic = 0;
+    }
 
-    void SceneManager::LoadFromFile(const std::string& path) {
-        std::ifstream ifs(path);
-        if (!ifs.is_open()) {
-            scenes = {
-                { "The Dark Knight", "assets/models/Batman.glb", "assets/musics/Somthing.ogg", glm::vec3(3,3,3), 0.5f },
-                { "Man of Tomorrow", "assets/models/Superman.glb", "assets/musics/Punkrocker.ogg", glm::vec3(2,2,2), 0.6f },
-                { "Heisenburg", "assets/models/Walter.glb", "assets/musics/BreakBad.ogg", glm::vec3(1,1,1), 0.4f }
-            };
-            SaveToFile(path);
-            return;
-        }
+    int SceneManager::FindMeshIndex(const std::string& path) const {
+        auto it = meshLookup.find(CanonicalPath(path));
+        return it == meshLookup.end() ? -1 : it->second;
+    }
+
+    int SceneManager::FindMusicIndex(const std::string& path) const {
+        auto it = musicLookup.find(CanonicalPath(path));
+        return it == musicLookup.end() ? -1 : it->second;
+    }
 
-        json j;
-        try {
-            ifs >> j;
-            scenes.clear();
-            for (const auto& s : j["scenes"]) {
-                glm::vec3 light(3.0f);
-                if (s.contains("lightPos") && s["lightPos"].is_array() && s["lightPos"].size() == 3) {
-                    light = glm::vec3(s["lightPos"][0], s["lightPos"][1], s["lightPos"][2]);
+    void SceneManager::updateSearch() {
+        SS_PROFILE_SCOPE("SceneManager::updateSearch");
+        std::string query = foldCase(searchBuf);
+        // Typing onto the previous query can only shrink its matches, so those
+        // are filtered instead of every scene
+        bool narrowing = !searchIndexDirty && !lastQuery.empty() && query.compare(0, lastQuery.size(), lastQuery) == 0;
+        if (searchIndexDirty) {
+            foldedNames.resize(scenes.size());
+            for (size_t i = 0; i < scenes.size(); ++i) foldedNames[i] = foldCase(scenes[i].name.c_str());
+            searchIndexDirty = false;
+        }
+        if (narrowing) {
+            searchResults.erase(std::remove_if(searchResults.begin(), searchResults.end(),
+                [&](int i) { return foldedNames[i].find(query) == std::string::npos; }), searchResults.end());
+        }
+        else {
+            searchResults.clear();
+            if (!query.empty()) {
+                for (int i = 0; i < static_cast<int>(foldedNames.size()); ++i) {
+                    if (foldedNames[i].find(query) != std::string::npos) searchResults.push_back(i);
                 }
+            }
+        }
+        lastQuery = std::move(query);
+    }
 
-                float ambient = s.value("ambientIntensity", 0.5f);
+    void SceneManager::updateMemoryCharge() {
+        size_t bytes = scenes.capacity() * sizeof(Scene);
+        for (const auto& s : scenes) {
+            bytes += s.name.capacity() + s.meshPath.capacity() + s.musicPath.capacity();
+            bytes += s.pointLights.capacity() * sizeof(PointLight);
+        }
+        libraryCharge.set(MemoryTag::SceneLibrary, bytes);
+    }
 
-                scenes.push_back({
-                    s.value("name", ""),
-                    s.value("meshPath", ""),
-                    s.value("musicPath", ""),
-                    light,
-                    ambient
-                    });
-            }
+    void SceneManager::RunListBenchmark(size_t count, std::function<unsigned int(const Scene&)> thumbnails) {
+        // Rows are cloned from the real library so they hit the real thumbnails
+        std::vector<Scene> templates;
+        std::string path = defaultLibraryPath();
+        std::error_code ec;
+        if (!fs::exists(path, ec) || !ReadLibrary(path, templates) || templates.empty()) {
+            templates.resize(1);
+            templates[0].meshPath = "assets/models/Batman.glb";
         }
-        catch (...) {
-            std::cerr << "Failed to parse scenes.json\n";
+
+        ImGuiContext* previous = ImGui::GetCurrentContext();
+        ImGuiContext* context = ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(1280.0f, 800.0f);
+        io.DeltaTime = 1.0f / 60.0f;
+        io.IniFilename = nullptr;
+        // No renderer here, ImGui keeps its font textures to itself
+        io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+
+        SceneManager manager{ Detached{} };
+        manager.thumbnailProvider = std::move(thumbnails);
+        glm::vec3 lightPos(3.0f);
+        float ambient = 0.5f;
+        std::vector<PointLight> pointLights;
+        auto frame = [&] {
+            ImGui::NewFrame();
+            ImGui::SetNextWindowSize(ImVec2(600.0f, 700.0f));
+            manager.renderImGui(lightPos, ambient, pointLights);
+            ImGui::Render();
+        };
+        // Every frame jumps a page, so every frame shows rows not seen before
+        auto scrollingFrames = [&](int frames) {
+            float rowHeight = manager.thumbnailProvider ? ImGui::GetFrameHeight() * 2.0f : ImGui::GetFrameHeight();
+            float page = 600.0f;
+            float maxScroll = std::max(0.0f, rowHeight * manager.scenes.size() - page);
+            float y = 0.0f;
+            double worst = 0.0;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; ++i) {
+                y += page;
+                if (y > maxScroll) y = 0.0f;
+                manager.pendingListScroll = y;
+                auto frameStart = std::chrono::steady_clock::now();
+                frame();
+                worst = std::max(worst, elapsedMs(frameStart));
+            }
+            return std::make_pair(elapsedMs(start) / frames, worst);
+        };
+
+        constexpr int kFrames = 200;
+        size_t sizes[2] = { std::min<size_t>(count, 1000), count };
+        std::printf("Scene list benchmark, %d frames each, %s thumbnails, rows cloned from %zu scenes\n",
+            kFrames, manager.thumbnailProvider ? "with" : "without", templates.size());
+        for (size_t scenesInList : sizes) {
+            manager.scenes.resize(scenesInList);
+            char buf[64];
+            for (size_t i = 0; i < scenesInList; ++i) {
+                manager.scenes[i] = templates[i % templates.size()];
+                std::snprintf(buf, sizeof(buf), "Scene %06zu", i);
+                manager.scenes[i].name = buf;
+            }
+            manager.OnScenesChanged();
+            manager.searchBuf[0] = '\0';
+            for (int i = 0; i < 10; ++i) frame();
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < kFrames; ++i) frame();
+            double frameMs = elapsedMs(start) / kFrames;
+            auto scrolled = scrollingFrames(kFrames);
+
+            std::snprintf(manager.searchBuf, sizeof(manager.searchBuf), "scene 0");
+            start = std::chrono::steady_clock::now();
+            manager.updateSearch();
+            double fullMs = elapsedMs(start);
+            size_t broad = manager.searchResults.size();
+            std::snprintf(manager.searchBuf, sizeof(manager.searchBuf), "scene 00");
+            start = std::chrono::steady_clock::now();
+            manager.updateSearch();
+            double narrowMs = elapsedMs(start);
+
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < kFrames; ++i) frame();
+            double filteredMs = elapsedMs(start) / kFrames;
+
+            std::printf("  %7zu scenes: %.3f ms/frame, scrolling %.3f ms/frame (worst %.3f), filtered %.3f ms/frame\n",
+                scenesInList, frameMs, scrolled.first, scrolled.second, filteredMs);
+            std::printf("  %7s         search %.2f ms (%zu hits), narrowed %.2f ms (%zu hits)\n",
+                "", fullMs, broad, narrowMs, manager.searchResults.size());
         }
+        ImGui::DestroyContext(context);
+        ImGui::SetCurrentContext(previous);
     }
 }
@@ -2,17 +2,41 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <memory>
+#include <unordered_map>
+#include <iosfwd>
 #include <glm/glm.hpp>
+#include "MemoryTracker.h"
+#include "SceneSaver.h"
+#include "AssetDatabase.h"
 
 
 namespace SS
 {
+    struct PointLight {
+        glm::vec3 position = glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec3 color = glm::vec3(1.0f);
+        float radius = 3.0f; // light reaches zero at this distance
+        float intensity = 1.0f;
+    };
+
     struct Scene {
         std::string name;
         std::string meshPath;
         std::string musicPath;
         glm::vec3 lightPos = glm::vec3(3.0f, 3.0f, 3.0f);
         float ambientIntensity = 0.5f;
+        std::vector<PointLight> pointLights;
+    };
+
+    // What the user picked in the editor this frame, as indices into the
+    // manager's lists; -1 when nothing happened.
+    struct SceneEditorEvents {
+        int meshSelected = -1;
+        int musicSelected = -1;
+        int sceneLoaded = -1;
+        // Listed models whose contents changed on disk since the last frame
+        std::vector<std::string> modelsChanged;
     };
 
     class SceneManager {
@@ -28,15 +52,79 @@ namespace SS
         SceneManager();
 
 
-        void renderImGui(std::function<void(const std::string&)> onMeshSelected,
-            std::function<void(const std::string&)> onMusicSelected,
-            std::function<void(const Scene&)> onSceneLoaded,
-            glm::vec3& currentLightPos,
-            float& currentAmbient);
+        SceneEditorEvents renderImGui(glm::vec3& currentLightPos,
+            float& currentAmbient,
+            std::vector<PointLight>& currentPointLights);
+        // JSON, or the binary library for *.sslib paths.
         void LoadFromFile(const std::string& path);
+        // Synchronous; edits made in the editor are saved in the background.
         void SaveToFile(const std::string& path) const;
+        // Replaces `scenes` with the records of the scenes.json document in
+        // `in`, streamed without building a DOM. Malformed records are skipped
+        // and counted; on a syntax error the records before it are kept and
+        // false is returned.
+        static bool ParseJson(std::istream& in, std::vector<Scene>& scenes, int* skippedRecords = nullptr);
 
         char sceneNameBuf[128] = { 0 };
+        char searchBuf[128] = { 0 };
+
+        // Call after changing `scenes` directly.
+        void OnScenesChanged();
+        // Selects the scene's mesh and music in the combos, now or once the
+        // asset database lists them.
+        void SelectAssets(const Scene& scene);
+        // Index into meshFiles/musicFiles of an asset path, -1 when not found.
+        int FindMeshIndex(const std::string& path) const;
+        int FindMusicIndex(const std::string& path) const;
+        // Separators unified, so saved paths match scanned ones.
+        static std::string CanonicalPath(const std::string& path);
+
+        // Times Scene Editor frames, scrolling and searches over `count` scenes
+        // cloned from the library, in a manager that reads nothing else and
+        // writes nothing. Uses its own ImGui context; `thumbnails` stands in
+        // for thumbnailProvider and may be empty.
+        static void RunListBenchmark(size_t count, std::function<unsigned int(const Scene&)> thumbnails);
+
+        // Returns a GL texture shown next to each saved scene, 0 for none.
+        std::function<unsigned int(const Scene&)> thumbnailProvider;
+
+    private:
+        // No library file and no asset database, for RunListBenchmark
+        struct Detached {};
+        explicit SceneManager(Detached);
+
+        MemoryCharge libraryCharge;
+        std::string libraryPath;
+
+        std::unique_ptr<AssetDatabase> assets; // null when detached
+        std::vector<AssetInfo> meshAssets;  // parallel to meshFiles
+        std::vector<AssetInfo> musicAssets; // parallel to musicFiles
+        // Paths the selection follows while the asset lists change under it
+        std::string wantedMesh;
+        std::string wantedMusic;
+
+        std::unordered_map<std::string, int> meshLookup;  // canonical path -> meshFiles index
+        std::unordered_map<std::string, int> musicLookup; // canonical path -> musicFiles index
+
+        // Lowercased names searched by substring; rebuilt after the scenes change
+        std::vector<std::string> foldedNames;
+        std::vector<int> searchResults; // scene indices matching lastQuery
+        std::string lastQuery;
+        bool searchIndexDirty = true;
+        float pendingListScroll = -1.0f; // applied to the list next frame
+
+        void updateSearch();
+        // Takes new asset lists from the database and keeps the selection on
+        // the wanted files.
+        void updateAssets(SceneEditorEvents& events);
+        void resolveSelection();
+        SceneSaver saver;
 
+        // Reads an existing library without touching the disk otherwise.
+        static bool ReadLibrary(const std::string& path, std::vector<Scene>& scenes);
+        // Re-measures `scenes` for the memory panel after it changed.
+        void updateMemoryCharge();
+        // After an edit the saver was already told about.
+        void scenesEdited();
     };
 }
\ No newline at end of file
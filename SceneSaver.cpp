@@ -0,0 +1,217 @@
+#include "SceneSaver.h"
+#include "SceneManager.h"
+#include "SceneLibrary.h"
+#include "Profiler.h"
+#include "Timing.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <iostream>
+#include <cstdio>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace SS
+{
+    namespace
+    {
+#ifdef _WIN32
+        bool writeDurably(const std::string& path, const std::string& contents) {
+            HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return false;
+            DWORD written = 0;
+            bool ok = WriteFile(file, contents.data(), static_cast<DWORD>(contents.size()), &written, nullptr)
+                && written == contents.size();
+            ok = ok && FlushFileBuffers(file);
+            return CloseHandle(file) && ok;
+        }
+
+        bool replaceFile(const std::string& from, const std::string& to) {
+            return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+        }
+#else
+        bool writeDurably(const std::string& path, const std::string& contents) {
+            int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) return false;
+            size_t done = 0;
+            while (done < contents.size()) {
+                ssize_t n = write(fd, contents.data() + done, contents.size() - done);
+                if (n <= 0) break;
+                done += static_cast<size_t>(n);
+            }
+            bool ok = done == contents.size() && fsync(fd) == 0;
+            return close(fd) == 0 && ok;
+        }
+
+        bool replaceFile(const std::string& from, const std::string& to) {
+            if (std::rename(from.c_str(), to.c_str()) != 0) return false;
+            // The rename is only durable once the directory entry is
+            fs::path dir = fs::path(to).parent_path();
+            int fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+            if (fd >= 0) {
+                fsync(fd);
+                close(fd);
+            }
+            return true;
+        }
+#endif
+    }
+
+    SceneSaver::SceneSaver() {
+        writer = std::thread(&SceneSaver::writerLoop, this);
+    }
+
+    SceneSaver::~SceneSaver() {
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        writer.join();
+    }
+
+    void SceneSaver::assign(const std::vector<Scene>& scenes) {
+        records.clear();
+        records.reserve(scenes.size());
+        for (const Scene& scene : scenes) records.push_back(std::make_shared<const Scene>(scene));
+    }
+
+    void SceneSaver::append(const Scene& scene) {
+        records.push_back(std::make_shared<const Scene>(scene));
+    }
+
+    void SceneSaver::replace(size_t index, const Scene& scene) {
+        // A snapshot still being written keeps the old record alive
+        if (index < records.size()) records[index] = std::make_shared<const Scene>(scene);
+    }
+
+    void SceneSaver::erase(size_t index) {
+        if (index < records.size()) records.erase(records.begin() + index);
+    }
+
+    void SceneSaver::request(const std::string& path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto now = Clock::now();
+            if (!pending) oldestRequest = now;
+            snapshot = records;
+            snapshotPath = path;
+            due = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(kDebounceMs));
+            pending = true;
+            ++counters.requests;
+        }
+        wake.notify_one();
+    }
+
+    void SceneSaver::flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!pending && !writing) return;
+        flushRequested = true;
+        wake.notify_one();
+        idle.wait(lock, [&] { return !pending && !writing; });
+    }
+
+    SceneSaveStats SceneSaver::stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        SceneSaveStats result = counters;
+        result.pending = pending || writing;
+        return result;
+    }
+
+    void SceneSaver::writerLoop() {
+        Profiler::setThreadName("Scene Saver");
+        Records taken;
+        std::vector<Scene> scenes;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [&] { return quit || pending; });
+            if (!pending) return;
+            // Every request moves the deadline, so a burst of edits is one write
+            while (!quit && !flushRequested && Clock::now() < due) wake.wait_until(lock, due);
+
+            taken.swap(snapshot);
+            std::string path = snapshotPath;
+            Clock::time_point requested = oldestRequest;
+            pending = false;
+            writing = true;
+            lock.unlock();
+
+            bool ok;
+            auto start = Clock::now();
+            {
+                SS_PROFILE_SCOPE("SceneSaver::write");
+                // Assigning into the previous write's scenes reuses their strings
+                scenes.resize(taken.size());
+                for (size_t i = 0; i < taken.size(); ++i) scenes[i] = *taken[i];
+                taken.clear();
+                ok = writeAtomically(path, encode(path, scenes));
+            }
+            double writeMs = elapsedMs(start);
+
+            lock.lock();
+            writing = false;
+            flushRequested = false;
+            if (ok) {
+                ++counters.writes;
+                counters.lastWriteMs = writeMs;
+                counters.lastLatencyMs = elapsedMs(requested);
+            }
+            else {
+                ++counters.failures;
+            }
+            idle.notify_all();
+        }
+    }
+
+    std::string SceneSaver::serialize(const std::vector<Scene>& scenes) {
+        json j;
+        for (const auto& s : scenes) {
+            json lights = json::array();
+            for (const auto& l : s.pointLights) {
+                lights.push_back({
+                    { "position", { l.position.x, l.position.y, l.position.z } },
+                    { "color", { l.color.r, l.color.g, l.color.b } },
+                    { "radius", l.radius },
+                    { "intensity", l.intensity }
+                    });
+            }
+            j["scenes"].push_back({
+                { "name", s.name },
+                { "meshPath", s.meshPath },
+                { "musicPath", s.musicPath },
+                { "lightPos", { s.lightPos.x, s.lightPos.y, s.lightPos.z } },
+                { "ambientIntensity", s.ambientIntensity },
+                { "pointLights", lights }
+                });
+        }
+        return j.dump(4);
+    }
+
+    std::string SceneSaver::encode(const std::string& path, const std::vector<Scene>& scenes) {
+        return SceneLibraryFile::isBinaryPath(path) ? SceneLibraryFile::encode(scenes) : serialize(scenes);
+    }
+
+    bool SceneSaver::writeAtomically(const std::string& path, const std::string& contents) {
+        std::string temp = path + ".tmp";
+        if (!writeDurably(temp, contents)) {
+            std::cerr << "Failed to open file for writing: " << temp << "\n";
+            std::remove(temp.c_str());
+            return false;
+        }
+        if (!replaceFile(temp, path)) {
+            std::cerr << "Failed to replace " << path << "\n";
+            std::remove(temp.c_str());
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace SS
+{
+    struct Scene;
+
+    struct SceneSaveStats {
+        int requests = 0;
+        int writes = 0;
+        int failures = 0;
+        double lastWriteMs = 0.0;   // serialize, write, sync and rename
+        double lastLatencyMs = 0.0; // oldest unsaved edit until the file was replaced
+        bool pending = false;
+    };
+
+    // Writes the scene library off the UI thread. The saver keeps its own copy
+    // of the library as immutable records that edits replace one at a time, so
+    // a request snapshots pointers rather than scenes. The writer waits until
+    // no newer request arrived for kDebounceMs and writes only the latest
+    // snapshot. The file is replaced atomically, so a crash leaves either the
+    // previous library or the new one on disk.
+    class SceneSaver {
+    public:
+        static constexpr double kDebounceMs = 300.0;
+
+        SceneSaver();
+        // Writes a pending snapshot before returning.
+        ~SceneSaver();
+
+        SceneSaver(const SceneSaver&) = delete;
+        SceneSaver& operator=(const SceneSaver&) = delete;
+
+        // Keep the saver's copy in step with the editor's scenes; assign()
+        // copies everything and is meant for loads, the others one record.
+        void assign(const std::vector<Scene>& scenes);
+        void append(const Scene& scene);
+        void replace(size_t index, const Scene& scene);
+        void erase(size_t index);
+
+        // Queues a write of the library as edited so far.
+        void request(const std::string& path);
+        // Skips the debounce and blocks until the pending snapshot is written.
+        void flush();
+        SceneSaveStats stats() const;
+
+        static std::string serialize(const std::vector<Scene>& scenes);
+        // serialize(), or the binary library format for *.sslib paths.
+        static std::string encode(const std::string& path, const std::vector<Scene>& scenes);
+        // Writes `contents` to a temporary file next to `path`, syncs it to disk
+        // and renames it over `path`.
+        static bool writeAtomically(const std::string& path, const std::string& contents);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+        using Records = std::vector<std::shared_ptr<const Scene>>;
+
+        Records records; // UI thread
+
+        std::thread writer;
+        mutable std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable idle;
+        Records snapshot;
+        std::string snapshotPath;
+        Clock::time_point due;
+        Clock::time_point oldestRequest;
+        bool pending = false;
+        bool writing = false;
+        bool flushRequested = false;
+        bool quit = false;
+        SceneSaveStats counters;
+
+        void writerLoop();
+    };
+}
@@ -0,0 +1,220 @@
+#include "ShadowMap.h"
+#include "Animation.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include <imgui.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace SS
+{
+    namespace
+    {
+        // Positions only, plus the skinning inputs so GPU skinned meshes cast the
+        // shadow of their animated pose
+        const char* depthVertexSource = R"(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in uvec4 aJoints;
+layout (location = 4) in vec4 aWeights;
+
+uniform mat4 model;
+uniform mat4 lightViewProj;
+uniform bool skinned;
+
+layout (std140) uniform JointPalette {
+    mat4 joints[128];
+};
+
+void main() {
+    vec4 localPos = vec4(aPos, 1.0);
+    if (skinned) {
+        mat4 skin = aWeights.x * joints[aJoints.x] + aWeights.y * joints[aJoints.y] +
+                    aWeights.z * joints[aJoints.z] + aWeights.w * joints[aJoints.w];
+        localPos = skin * localPos;
+    }
+    gl_Position = lightViewProj * model * localPos;
+}
+)";
+
+        const char* depthFragmentSource = R"(
+#version 330 core
+void main() {
+}
+)";
+
+        GLuint compileStage(GLenum type, const char* source) {
+            GLuint shader = glCreateShader(type);
+            glShaderSource(shader, 1, &source, nullptr);
+            glCompileShader(shader);
+            GLint success = 0;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            if (!success) {
+                char infoLog[512];
+                glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+                std::cerr << "Shadow shader compilation error:\n" << infoLog << "\n";
+            }
+            return shader;
+        }
+    }
+
+    void ShadowMap::init() {
+        GLuint vs = compileStage(GL_VERTEX_SHADER, depthVertexSource);
+        GLuint fs = compileStage(GL_FRAGMENT_SHADER, depthFragmentSource);
+        program = glCreateProgram();
+        glAttachShader(program, vs);
+        glAttachShader(program, fs);
+        glLinkProgram(program);
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            char infoLog[512];
+            glGetProgramInfoLog(program, 512, nullptr, infoLog);
+            std::cerr << "Shadow shader linking error:\n" << infoLog << "\n";
+        }
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+
+        GLuint paletteBlock = glGetUniformBlockIndex(program, "JointPalette");
+        if (paletteBlock != GL_INVALID_INDEX) {
+            glUniformBlockBinding(program, paletteBlock, JointPaletteBuffer::kBindingPoint);
+        }
+        allocate(resolution);
+    }
+
+    void ShadowMap::shutdown() {
+        if (fbo) glDeleteFramebuffers(1, &fbo);
+        if (depthTexture) GpuMemory::deleteTextures(1, &depthTexture);
+        if (program) glDeleteProgram(program);
+        fbo = depthTexture = program = 0;
+        allocatedResolution = 0;
+    }
+
+    bool ShadowMap::allocate(int size) {
+        if (fbo) glDeleteFramebuffers(1, &fbo);
+        if (depthTexture) GpuMemory::deleteTextures(1, &depthTexture);
+        fbo = depthTexture = 0;
+        allocatedResolution = 0;
+        dirty = true;
+
+        glGenTextures(1, &depthTexture);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        GpuMemory::texImage2D(depthTexture, GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size, size, GL_DEPTH_COMPONENT, GL_FLOAT,
+            nullptr, MemoryTag::GpuRenderTargets);
+        // Hardware depth comparison with bilinear filtering, every tap of the
+        // shader's PCF kernel is already a 2x2 filtered result
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        // Outside the light frustum counts as lit
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        const float border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!complete) {
+            std::cerr << "Shadow map framebuffer is incomplete (" << size << "x" << size << ")\n";
+            return false;
+        }
+        allocatedResolution = size;
+        return true;
+    }
+
+    bool ShadowMap::beginUpdate(const glm::vec3& lightPos, const glm::mat4& casterTransform, uint64_t casterRevision,
+        const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+        if (!enabled || !program) return false;
+        if (resolution != allocatedResolution && !allocate(resolution)) return false;
+
+        if (!dirty && lightPos == cachedLight && casterTransform == cachedTransform && casterRevision == cachedRevision) {
+            ++cachedFrames;
+            return false;
+        }
+        dirty = false;
+        cachedLight = lightPos;
+        cachedTransform = casterTransform;
+        cachedRevision = casterRevision;
+
+        // Bounding sphere of the casters in world space
+        glm::vec3 lo(0.0f), hi(0.0f);
+        for (int i = 0; i < 8; ++i) {
+            glm::vec3 corner((i & 1) ? boundsMax.x : boundsMin.x, (i & 2) ? boundsMax.y : boundsMin.y,
+                (i & 4) ? boundsMax.z : boundsMin.z);
+            glm::vec3 world = glm::vec3(casterTransform * glm::vec4(corner, 1.0f));
+            lo = i == 0 ? world : glm::min(lo, world);
+            hi = i == 0 ? world : glm::max(hi, world);
+        }
+        glm::vec3 center = (lo + hi) * 0.5f;
+        float radius = std::max(glm::length(hi - lo) * 0.5f, 0.01f);
+
+        // Tightest perspective frustum from the light that contains the sphere
+        glm::vec3 toCenter = center - lightPos;
+        float distance = glm::length(toCenter);
+        glm::vec3 up = distance > 0.0f && std::abs(toCenter.y / distance) > 0.99f ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+        glm::mat4 lightView = glm::lookAt(lightPos, distance > 0.0f ? center : lightPos + glm::vec3(0, -1, 0), up);
+        float fov = glm::radians(150.0f);
+        float nearPlane = 0.05f;
+        if (distance > radius * 1.05f) {
+            fov = 2.0f * std::asin(radius / distance);
+            nearPlane = std::max(distance - radius, 0.05f);
+        }
+        glm::mat4 lightProjection = glm::perspective(fov, 1.0f, nearPlane, distance + radius);
+        lightViewProj = lightProjection * lightView;
+
+        glGetIntegerv(GL_VIEWPORT, savedViewport);
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &savedFramebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, allocatedResolution, allocatedResolution);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(1.5f, 4.0f);
+
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "lightViewProj"), 1, GL_FALSE, glm::value_ptr(lightViewProj));
+        ++renderCount;
+        return true;
+    }
+
+    void ShadowMap::endUpdate() {
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glBindFramebuffer(GL_FRAMEBUFFER, savedFramebuffer);
+        glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+    }
+
+    void ShadowMap::applyTo(GLuint shaderProgram) const {
+        glUseProgram(shaderProgram);
+        glUniform1i(glGetUniformLocation(shaderProgram, "shadowsEnabled"), enabled && allocatedResolution > 0);
+        glUniform1i(glGetUniformLocation(shaderProgram, "shadowMap"), kTextureUnit);
+        glUniform1f(glGetUniformLocation(shaderProgram, "shadowBias"), depthBias);
+        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "lightSpaceMatrix"), 1, GL_FALSE, glm::value_ptr(lightViewProj));
+        glActiveTexture(GL_TEXTURE0 + kTextureUnit);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void ShadowMap::renderImGui() {
+        ImGui::Begin("Shadows");
+        ImGui::Checkbox("Enabled", &enabled);
+        const int sizes[] = { 512, 1024, 2048, 4096 };
+        const char* labels[] = { "512", "1024", "2048", "4096" };
+        int current = static_cast<int>(std::find(sizes, sizes + 4, resolution) - sizes);
+        if (ImGui::Combo("Resolution", &current, labels, IM_ARRAYSIZE(labels))) {
+            resolution = sizes[std::min(current, 3)];
+        }
+        ImGui::SliderFloat("Depth Bias", &depthBias, 0.0f, 0.01f, "%.4f");
+        if (ImGui::Button("Force Redraw")) invalidate();
+        ImGui::Text("Redraws: %u  Frames served from cache: %u", renderCount, cachedFrames);
+        ImGui::End();
+    }
+}
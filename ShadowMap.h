@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+namespace SS
+{
+    // Depth map for the scene's point light, rendered with a perspective frustum
+    // fitted around the casters. The map is cached: beginUpdate() only asks for
+    // a redraw when the light, the caster transform or the caster revision moved,
+    // so camera-only changes cost no shadow work.
+    class ShadowMap {
+    public:
+        static constexpr GLuint kTextureUnit = 1;
+
+        bool enabled = true;
+        int resolution = 2048;
+        float depthBias = 0.0015f;
+
+        void init();
+        void shutdown();
+
+        // Returns true when the cached map is stale. The shadow framebuffer and
+        // depth program are then bound, and the caller draws the casters with
+        // depthProgram() before calling endUpdate().
+        bool beginUpdate(const glm::vec3& lightPos, const glm::mat4& casterTransform, uint64_t casterRevision,
+            const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+        void endUpdate();
+        void invalidate() { dirty = true; }
+
+        GLuint depthProgram() const { return program; }
+        const glm::mat4& lightViewProjection() const { return lightViewProj; }
+        // Binds the map to kTextureUnit and sets the receiver uniforms of `shaderProgram`.
+        void applyTo(GLuint shaderProgram) const;
+
+        void renderImGui();
+
+    private:
+        GLuint fbo = 0;
+        GLuint depthTexture = 0;
+        GLuint program = 0;
+        int allocatedResolution = 0;
+
+        bool dirty = true;
+        glm::vec3 cachedLight{ 0.0f };
+        glm::mat4 cachedTransform{ 1.0f };
+        uint64_t cachedRevision = 0;
+        glm::mat4 lightViewProj{ 1.0f };
+
+        GLint savedViewport[4] = { 0, 0, 0, 0 };
+        GLint savedFramebuffer = 0;
+
+        uint32_t renderCount = 0;
+        uint32_t cachedFrames = 0;
+
+        bool allocate(int size);
+    };
+}
@@ -2,12 +2,48 @@
 #define MA_ENABLE_MP3
 #include "miniaudio.h"
 #include "SoundManager.h"
-#include <thread>
+#include "Profiler.h"
+#include "MemoryTracker.h"
 #include <iostream>
+#include <cstdlib>
 
 
 namespace SS
 {
+    namespace
+    {
+        // miniaudio frees without a size, so each block carries its own in a
+        // header that keeps the payload 16-byte aligned
+        constexpr size_t kHeaderBytes = 16;
+
+        void* audioMalloc(size_t size, void*) {
+            unsigned char* block = static_cast<unsigned char*>(std::malloc(size + kHeaderBytes));
+            if (!block) return nullptr;
+            *reinterpret_cast<size_t*>(block) = size;
+            MemoryTracker::allocated(MemoryTag::Audio, size);
+            return block + kHeaderBytes;
+        }
+
+        void audioFree(void* p, void*) {
+            if (!p) return;
+            unsigned char* block = static_cast<unsigned char*>(p) - kHeaderBytes;
+            MemoryTracker::freed(MemoryTag::Audio, *reinterpret_cast<size_t*>(block));
+            std::free(block);
+        }
+
+        void* audioRealloc(void* p, size_t size, void* userData) {
+            if (!p) return audioMalloc(size, userData);
+            unsigned char* block = static_cast<unsigned char*>(p) - kHeaderBytes;
+            size_t oldSize = *reinterpret_cast<size_t*>(block);
+            unsigned char* grown = static_cast<unsigned char*>(std::realloc(block, size + kHeaderBytes));
+            if (!grown) return nullptr;
+            *reinterpret_cast<size_t*>(grown) = size;
+            MemoryTracker::freed(MemoryTag::Audio, oldSize);
+            MemoryTracker::allocated(MemoryTag::Audio, size);
+            return grown + kHeaderBytes;
+        }
+    }
+
     SoundManager::SoundManager()
         : engine{}, currentSound{} 
     {
@@ -23,7 +59,11 @@ namespace SS
 
     int SoundManager::init()
     {
-        if (ma_engine_init(NULL, &engine) != MA_SUCCESS) {
+        ma_engine_config config = ma_engine_config_init();
+        config.allocationCallbacks.onMalloc = audioMalloc;
+        config.allocationCallbacks.onRealloc = audioRealloc;
+        config.allocationCallbacks.onFree = audioFree;
+        if (ma_engine_init(&config, &engine) != MA_SUCCESS) {
             return -1;
         }
         return 1;
@@ -31,6 +71,7 @@ namespace SS
 
     void SoundManager::playMusic(const std::string& filePath)
     {
+        SS_PROFILE_SCOPE("SoundManager::playMusic");
         // Stop and uninit previous sound
         if (hasSound) {
             ma_sound_stop(&currentSound);
@@ -38,11 +79,9 @@ namespace SS
             hasSound = false;
         }
 
-        // Delay before playing
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-        // Init and play new sound
-        if (ma_sound_init_from_file(&engine, filePath.c_str(), 0, NULL, NULL, &currentSound) == MA_SUCCESS) {
+        // Stream the file so the track is decoded on the audio thread instead of
+        // fully up front here
+        if (ma_sound_init_from_file(&engine, filePath.c_str(), MA_SOUND_FLAG_STREAM, NULL, NULL, &currentSound) == MA_SUCCESS) {
             ma_sound_start(&currentSound);
             hasSound = true;
         }
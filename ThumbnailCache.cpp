@@ -0,0 +1,195 @@
+#include "ThumbnailCache.h"
+#include "ModelManager.h"
+#include "RenderTarget.h"
+#include "MemoryTracker.h"
+#include "stb_image.h"
+#include "stb_image_write.h"
+#include "Hash.h"
+#include <imgui.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <cstdio>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+namespace SS
+{
+    namespace
+    {
+        // Bump when the thumbnail shading changes so older PNGs count as stale
+        constexpr uint32_t kThumbnailVersion = 2;
+
+        uint64_t hashSceneFields(const Scene& scene) {
+            uint64_t h = fnv1a(&kThumbnailVersion, sizeof(kThumbnailVersion));
+            h = fnv1a(scene.meshPath, h);
+            h = fnv1a(&scene.lightPos, sizeof(scene.lightPos), h);
+            h = fnv1a(&scene.ambientIntensity, sizeof(scene.ambientIntensity), h);
+            return h;
+        }
+    }
+
+    ThumbnailCache::ThumbnailCache(std::string dir)
+        : directory(std::move(dir))
+    {
+    }
+
+    ThumbnailCache::~ThumbnailCache() {
+        release();
+    }
+
+    void ThumbnailCache::release() {
+        for (auto& entry : textures) {
+            if (entry.second.texture) GpuMemory::deleteTextures(1, &entry.second.texture);
+        }
+        textures.clear();
+        recentUse.clear();
+    }
+
+    void ThumbnailCache::drop(std::unordered_map<uint64_t, Entry>::iterator it) {
+        if (it->second.texture) GpuMemory::deleteTextures(1, &it->second.texture);
+        recentUse.erase(it->second.use);
+        textures.erase(it);
+    }
+
+    void ThumbnailCache::invalidate(const std::string& meshPath) {
+        std::string canonical = SceneManager::CanonicalPath(meshPath);
+        for (auto it = textures.begin(); it != textures.end();) {
+            auto next = std::next(it);
+            if (it->second.meshPath == canonical) drop(it);
+            it = next;
+        }
+    }
+
+    uint64_t ThumbnailCache::inputKey(const Scene& scene) const {
+        uint64_t h = hashSceneFields(scene);
+        std::error_code ec;
+        auto size = fs::file_size(scene.meshPath, ec);
+        if (ec) return 0;
+        auto mtime = fs::last_write_time(scene.meshPath, ec).time_since_epoch().count();
+        if (ec) return 0;
+        h = fnv1a(&size, sizeof(size), h);
+        h = fnv1a(&mtime, sizeof(mtime), h);
+        int thumbSize = kSize;
+        return fnv1a(&thumbSize, sizeof(thumbSize), h);
+    }
+
+    std::string ThumbnailCache::pathFor(uint64_t key) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.png", static_cast<unsigned long long>(key));
+        return (fs::path(directory) / name).string();
+    }
+
+    int ThumbnailCache::generate(const std::vector<Scene>& scenes, const DrawFn& draw) {
+        std::error_code ec;
+        fs::create_directories(directory, ec);
+
+        RenderTarget target;
+        if (!target.ensureSize(kSize, kSize)) return 0;
+
+        std::unordered_set<std::string> referenced;
+        std::vector<unsigned char> pixels(kSize * kSize * 4);
+        std::vector<unsigned char> flipped(pixels.size());
+        int written = 0;
+
+        for (const auto& scene : scenes) {
+            uint64_t key = inputKey(scene);
+            if (key == 0) {
+                std::cerr << "Thumbnail skipped, mesh not found: " << scene.meshPath << "\n";
+                continue;
+            }
+            std::string path = pathFor(key);
+            referenced.insert(fs::path(path).filename().string());
+            if (fs::exists(path, ec)) continue;
+
+            Model model;
+            if (!model.LoadFromFile(scene.meshPath)) continue;
+
+            // Frame the model's bounds from slightly above and to the left
+            glm::vec3 boundsMin(0.0f), boundsMax(0.0f);
+            model.GetBounds(boundsMin, boundsMax);
+            glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+            float radius = std::max(0.01f, glm::length(boundsMax - boundsMin) * 0.5f);
+            float fov = glm::radians(37.0f);
+            float distance = radius / std::sin(fov * 0.5f);
+            glm::vec3 camPos = center + glm::normalize(glm::vec3(-0.2f, 0.15f, 1.0f)) * distance;
+            glm::mat4 view = glm::lookAt(camPos, center, glm::vec3(0, 1, 0));
+            glm::mat4 projection = glm::perspective(fov, 1.0f, distance * 0.01f, distance + radius * 2.0f);
+
+            target.bind();
+            glViewport(0, 0, kSize, kSize);
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            draw(model, view, projection, camPos, scene);
+
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, kSize, kSize, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            // GL rows are bottom-up, PNG rows top-down
+            size_t stride = kSize * 4;
+            for (int y = 0; y < kSize; ++y) {
+                std::memcpy(&flipped[y * stride], &pixels[(kSize - 1 - y) * stride], stride);
+            }
+            if (stbi_write_png(path.c_str(), kSize, kSize, 4, flipped.data(), static_cast<int>(stride))) {
+                ++written;
+                std::cout << "Thumbnail written: " << scene.name << " -> " << path << "\n";
+            }
+            else {
+                std::cerr << "Failed to write thumbnail: " << path << "\n";
+            }
+        }
+
+        for (const auto& entry : fs::directory_iterator(directory, ec)) {
+            if (entry.path().extension() == ".png" && !referenced.count(entry.path().filename().string())) {
+                fs::remove(entry.path(), ec);
+            }
+        }
+
+        target.release();
+        return written;
+    }
+
+    GLuint ThumbnailCache::get(const Scene& scene) {
+        uint64_t fieldsKey = hashSceneFields(scene);
+        auto it = textures.find(fieldsKey);
+        if (it != textures.end()) {
+            recentUse.splice(recentUse.begin(), recentUse, it->second.use);
+            return it->second.texture;
+        }
+
+        // Scrolling a long list shows many new rows at once; their files are
+        // read over the next frames instead of all in this one
+        int frame = ImGui::GetCurrentContext() ? ImGui::GetFrameCount() : loadFrame + 1;
+        if (frame != loadFrame) {
+            loadFrame = frame;
+            loadsThisFrame = 0;
+        }
+        if (loadsThisFrame >= kLoadsPerFrame) return 0;
+        ++loadsThisFrame;
+
+        while (textures.size() >= kMaxTextures) drop(textures.find(recentUse.back()));
+
+        GLuint tex = 0;
+        uint64_t key = inputKey(scene);
+        int width = 0, height = 0, comp = 0;
+        unsigned char* data = key ? stbi_load(pathFor(key).c_str(), &width, &height, &comp, 4) : nullptr;
+        if (data) {
+            glGenTextures(1, &tex);
+            glBindTexture(GL_TEXTURE_2D, tex);
+            GpuMemory::texImage2D(tex, GL_TEXTURE_2D, 0, GL_RGBA8, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data,
+                MemoryTag::GpuTextures);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            stbi_image_free(data);
+        }
+        // Misses are remembered too, so a scene without a thumbnail costs one lookup
+        recentUse.push_front(fieldsKey);
+        textures[fieldsKey] = { tex, SceneManager::CanonicalPath(scene.meshPath), recentUse.begin() };
+        return tex;
+    }
+}
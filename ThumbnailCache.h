@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <list>
+#include <functional>
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "SceneManager.h"
+
+namespace SS
+{
+    class Model;
+
+    // Scene thumbnails rendered offscreen and cached as PNGs. Files are named by a
+    // hash of everything that affects the image (mesh file size and mtime, light,
+    // ambient), so unchanged scenes are skipped and the editor never renders them live.
+    // The editor keeps at most kMaxTextures of them as GL textures, least recently
+    // shown evicted first, and reads at most kLoadsPerFrame PNGs per UI frame.
+    class ThumbnailCache {
+    public:
+        static constexpr int kSize = 128;
+        static constexpr size_t kMaxTextures = 256;
+        static constexpr int kLoadsPerFrame = 2;
+
+        using DrawFn = std::function<void(const Model& model, const glm::mat4& view, const glm::mat4& projection,
+            const glm::vec3& camPos, const Scene& scene)>;
+
+        explicit ThumbnailCache(std::string directory = "cache/thumbnails");
+        ~ThumbnailCache();
+
+        // Renders every scene whose thumbnail is missing or stale and removes
+        // thumbnails no scene refers to. Returns the number of images written.
+        int generate(const std::vector<Scene>& scenes, const DrawFn& draw);
+
+        // GL texture of the cached thumbnail, 0 when there is none on disk or
+        // this frame's loads are used up (it is then read on a later call).
+        GLuint get(const Scene& scene);
+        // Drops the textures of scenes showing `meshPath`, call after the file
+        // changed; get() then looks for the thumbnail of the new contents.
+        void invalidate(const std::string& meshPath);
+        void release();
+
+        size_t residentCount() const { return textures.size(); }
+
+    private:
+        struct Entry {
+            GLuint texture = 0;
+            std::string meshPath; // canonical
+            std::list<uint64_t>::iterator use;
+        };
+
+        std::string directory;
+        std::unordered_map<uint64_t, Entry> textures; // scene fields hash -> texture
+        std::list<uint64_t> recentUse; // keys of `textures`, most recently shown first
+        int loadFrame = -1;
+        int loadsThisFrame = 0;
+
+        void drop(std::unordered_map<uint64_t, Entry>::iterator it);
+
+        uint64_t inputKey(const Scene& scene) const;
+        std::string pathFor(uint64_t key) const;
+    };
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <chrono>
+
+namespace SS
+{
+    // Milliseconds since `start` on the steady clock.
+    inline double elapsedMs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
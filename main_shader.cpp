@@ -17,9 +17,33 @@
 #include "ModelManager.h"
 #include "SceneManager.h"
 #include "SoundManager.h"
+#include "OcclusionCuller.h"
+#include "FramePacer.h"
+#include "RenderTarget.h"
+#include "ThumbnailCache.h"
+#include "FrameCapture.h"
+#include "GpuProfiler.h"
+#include "Profiler.h"
+#include "Animation.h"
+#include "Crowd.h"
+#include "ShadowMap.h"
+#include "ClusteredLighting.h"
+#include "MaterialLibrary.h"
+#include "Meshlet.h"
+#include "JobSystem.h"
+#include "FramePipeline.h"
+#include "EditorCommands.h"
+#include "FrameArena.h"
+#include "AllocationCounter.h"
+#include "MemoryTracker.h"
+#include "ResourcePools.h"
+#include "SceneLibrary.h"
 
 #include <iostream>
 #include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
 
 
 // Vertex Shader source code
@@ -28,20 +52,40 @@ const char* vertexShaderSource = R"(
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in uvec4 aJoints;
+layout (location = 4) in vec4 aWeights;
 
 out vec3 Normal;
 out vec2 TexCoord;
 out vec3 FragPos;
+out vec4 LightSpacePos;
+out float ViewDepth;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform mat4 lightSpaceMatrix;
+uniform bool skinned;
+
+layout (std140) uniform JointPalette {
+    mat4 joints[128];
+};
 
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    vec4 localPos = vec4(aPos, 1.0);
+    vec3 localNormal = aNormal;
+    if (skinned) {
+        mat4 skin = aWeights.x * joints[aJoints.x] + aWeights.y * joints[aJoints.y] +
+                    aWeights.z * joints[aJoints.z] + aWeights.w * joints[aJoints.w];
+        localPos = skin * localPos;
+        localNormal = mat3(skin) * aNormal;
+    }
+    FragPos = vec3(model * localPos);
+    LightSpacePos = lightSpaceMatrix * vec4(FragPos, 1.0);
+    ViewDepth = -(view * vec4(FragPos, 1.0)).z;
+    Normal = mat3(transpose(inverse(model))) * localNormal;
     TexCoord = aTexCoord;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * model * localPos;
 }
 )";
 
@@ -51,26 +95,118 @@ const char* fragmentShaderSource = R"(
 in vec3 Normal;
 in vec2 TexCoord;
 in vec3 FragPos;
+in vec4 LightSpacePos;
+in float ViewDepth;
 
 out vec4 FragColor;
 
 uniform float ambientIntensity;
 uniform vec3 lightPos;
 uniform vec3 viewPos;
-uniform bool hasBaseColor;
-uniform sampler2D baseColorTexture;
+uniform bool shadowsEnabled;
+uniform sampler2DShadow shadowMap;
+uniform float shadowBias;
+
+uniform bool clusteredLighting;
+uniform samplerBuffer pointLightData;       // 2 texels per light: position + radius, color
+uniform usamplerBuffer clusterGrid;         // offset, count per cluster
+uniform usamplerBuffer clusterLightIndices;
+uniform vec2 clusterViewport;
+uniform ivec3 clusterDims;
+uniform vec2 clusterDepth;                  // near plane, slices / log(far / near)
+
+// Shared material table, see SS::MaterialData
+struct Material {
+    vec4 baseColorFactor;
+    float metallic;
+    float roughness;
+    int textureLayer; // layer * MATERIAL_SIZE_CLASSES + size class
+    int flags;
+};
+layout (std140) uniform MaterialTable {
+    Material materials[256];
+};
+uniform int materialIndex;
+// One layer array per size class, see SS::MaterialLibrary
+const int MATERIAL_SIZE_CLASSES = 5;
+uniform sampler2DArray materialTextures[MATERIAL_SIZE_CLASSES];
+
+const int MATERIAL_HAS_BASE_COLOR_TEXTURE = 1;
+const int MATERIAL_DOUBLE_SIDED = 2;
+
+// GLSL 3.30 only indexes sampler arrays with constants; the class is uniform per draw
+vec4 sampleMaterialTexture(int index, vec2 uv) {
+    int sizeClass = index % MATERIAL_SIZE_CLASSES;
+    vec3 coord = vec3(uv, float(index / MATERIAL_SIZE_CLASSES));
+    if (sizeClass == 0) return texture(materialTextures[0], coord);
+    if (sizeClass == 1) return texture(materialTextures[1], coord);
+    if (sizeClass == 2) return texture(materialTextures[2], coord);
+    if (sizeClass == 3) return texture(materialTextures[3], coord);
+    return texture(materialTextures[4], coord);
+}
+
+// 3x3 PCF over hardware-filtered depth comparisons, 1.0 means fully lit
+float shadowFactor() {
+    if (!shadowsEnabled) return 1.0;
+    vec3 p = LightSpacePos.xyz / LightSpacePos.w * 0.5 + 0.5;
+    if (p.z > 1.0) return 1.0;
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0));
+    float lit = 0.0;
+    for (int x = -1; x <= 1; ++x) {
+        for (int y = -1; y <= 1; ++y) {
+            lit += texture(shadowMap, vec3(p.xy + vec2(x, y) * texel, p.z - shadowBias));
+        }
+    }
+    return lit / 9.0;
+}
+
+// Point lights listed for this fragment's froxel
+vec3 pointLighting(vec3 norm) {
+    if (!clusteredLighting) return vec3(0.0);
+    int slice = int(log(max(ViewDepth, clusterDepth.x) / clusterDepth.x) * clusterDepth.y);
+    if (slice >= clusterDims.z) return vec3(0.0);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterViewport * vec2(clusterDims.xy)), ivec2(0), clusterDims.xy - 1);
+    int cluster = tile.x + tile.y * clusterDims.x + slice * clusterDims.x * clusterDims.y;
+    uvec2 range = texelFetch(clusterGrid, cluster).xy;
+
+    vec3 sum = vec3(0.0);
+    for (uint i = 0u; i < range.y; ++i) {
+        int light = int(texelFetch(clusterLightIndices, int(range.x + i)).r);
+        vec4 positionRadius = texelFetch(pointLightData, light * 2);
+        vec3 color = texelFetch(pointLightData, light * 2 + 1).rgb;
+        vec3 toLight = positionRadius.xyz - FragPos;
+        float dist = length(toLight);
+        float falloff = clamp(1.0 - dist / positionRadius.w, 0.0, 1.0);
+        sum += max(dot(norm, toLight / max(dist, 1e-4)), 0.0) * color * falloff * falloff;
+    }
+    return sum;
+}
 
 void main() {
+    Material material = materials[materialIndex];
     vec3 norm = normalize(Normal);
+    if ((material.flags & MATERIAL_DOUBLE_SIDED) != 0 && !gl_FrontFacing) norm = -norm;
+
     vec3 lightColor = vec3(1.0);
     vec3 ambient = ambientIntensity * lightColor;
     vec3 lightDir = normalize(lightPos - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
-    vec3 result = ambient + diffuse;
+    float shadow = shadowFactor();
+    vec3 diffuse = diff * lightColor * shadow;
+    vec3 result = ambient + diffuse + pointLighting(norm);
+
+    vec4 color = material.baseColorFactor;
+    if ((material.flags & MATERIAL_HAS_BASE_COLOR_TEXTURE) != 0) {
+        color *= sampleMaterialTexture(material.textureLayer, TexCoord);
+    }
 
-    vec4 color = hasBaseColor ? texture(baseColorTexture, TexCoord) : vec4(result,1.0);
-    FragColor = color * vec4(result, 1.0);
+    // Blinn-Phong highlight driven by the glTF metallic/roughness factors
+    vec3 halfDir = normalize(lightDir + normalize(viewPos - FragPos));
+    float shininess = mix(256.0, 4.0, material.roughness);
+    vec3 specularColor = mix(vec3(0.04), color.rgb, material.metallic);
+    vec3 specular = specularColor * pow(max(dot(norm, halfDir), 0.0), shininess) * (1.0 - material.roughness) * shadow;
+
+    FragColor = vec4(color.rgb * result + specular, color.a);
 }
 )";
 
@@ -112,9 +248,59 @@ unsigned int createShaderProgram() {
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
+    GLuint paletteBlock = glGetUniformBlockIndex(shaderProgram, "JointPalette");
+    if (paletteBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(shaderProgram, paletteBlock, SS::JointPaletteBuffer::kBindingPoint);
+    }
+    GLuint materialBlock = glGetUniformBlockIndex(shaderProgram, "MaterialTable");
+    if (materialBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(shaderProgram, materialBlock, SS::MaterialLibrary::kBindingPoint);
+    }
+
+    // Every sampler gets its own unit, samplers of different types reading the
+    // same unit make every draw invalid
+    glUseProgram(shaderProgram);
+    glUniform1i(glGetUniformLocation(shaderProgram, "shadowMap"), SS::ShadowMap::kTextureUnit);
+    glUniform1i(glGetUniformLocation(shaderProgram, "pointLightData"), SS::ClusteredLighting::kLightDataUnit);
+    glUniform1i(glGetUniformLocation(shaderProgram, "clusterGrid"), SS::ClusteredLighting::kClusterGridUnit);
+    glUniform1i(glGetUniformLocation(shaderProgram, "clusterLightIndices"), SS::ClusteredLighting::kLightIndexUnit);
+    GLint materialUnits[SS::MaterialLibrary::kSizeClasses];
+    for (int i = 0; i < SS::MaterialLibrary::kSizeClasses; ++i) {
+        materialUnits[i] = static_cast<GLint>(SS::MaterialLibrary::kTextureUnit) + i;
+    }
+    glUniform1iv(glGetUniformLocation(shaderProgram, "materialTextures"), SS::MaterialLibrary::kSizeClasses, materialUnits);
+    glUseProgram(0);
+
     return shaderProgram;
 }
 
+// Latest framebuffer size, written by the GLFW resize callback. Render targets
+// pick it up lazily at the start of the next frame.
+int framebufferWidth = 1280;
+int framebufferHeight = 800;
+
+void onFramebufferResize(GLFWwindow*, int width, int height) {
+    framebufferWidth = width;
+    framebufferHeight = height;
+}
+
+// Set the per-draw uniforms of the scene shader and draw the model
+void drawModel(unsigned int shaderProgram, const SS::Model& model, SS::SkinningMode skinning, const glm::mat4& modelMatrix,
+    const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::vec3& camPos,
+    const glm::vec3& lightPos, float ambientIntensity, const std::vector<uint8_t>* visibility = nullptr,
+    const SS::MeshletDrawList* meshlets = nullptr) {
+    glUseProgram(shaderProgram);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(modelMatrix));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+
+    glUniform1f(glGetUniformLocation(shaderProgram, "ambientIntensity"), ambientIntensity);
+    glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos"), 1, glm::value_ptr(lightPos));
+    glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(camPos));
+
+    model.Draw(shaderProgram, skinning, visibility, meshlets);
+}
+
 // Load scene's model and music
 void loadScene(const SS::Scene& scene, SS::Model& model, SS::SoundManager& soundManager, std::string& currentMusic) {
     std::cout << "Loading Scene: " << scene.name << "\n";
@@ -127,10 +313,55 @@ void loadScene(const SS::Scene& scene, SS::Model& model, SS::SoundManager& sound
     currentMusic = scene.musicPath;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    SS::Profiler::setThreadName("Main");
+
+    // --thumbnails renders the thumbnail cache with a hidden window and exits
+    // --alloc-check runs a fixed number of frames and exits with 1 if any frame
+    // after the warmup allocated from the heap, or 2 when the build does not
+    // count allocations, so scripts can tell "not checked" from "passed"
+    // --convert-scenes <in.json> <out.sslib> writes a binary scene library
+    // --scene-benchmark [count] compares JSON and binary library startup
+    // --scene-list-benchmark [count] times the Scene Editor list, with thumbnails,
+    // scrolling and search, using a hidden window
+    bool headlessThumbnails = false;
+    bool allocCheck = false;
+    size_t listBenchmarkCount = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--thumbnails") == 0) headlessThumbnails = true;
+        if (std::strcmp(argv[i], "--alloc-check") == 0) allocCheck = true;
+        if (std::strcmp(argv[i], "--convert-scenes") == 0) {
+            if (i + 2 >= argc) {
+                std::cerr << "Usage: --convert-scenes <in.json> <out.sslib>\n";
+                return 1;
+            }
+            return SS::SceneLibraryFile::convert(argv[i + 1], argv[i + 2]) ? 0 : 1;
+        }
+        if (std::strcmp(argv[i], "--scene-benchmark") == 0) {
+            size_t count = i + 1 < argc ? std::strtoul(argv[i + 1], nullptr, 10) : 0;
+            SS::SceneLibraryFile::runBenchmark(count > 0 ? count : 100000);
+            return 0;
+        }
+        if (std::strcmp(argv[i], "--scene-list-benchmark") == 0) {
+            size_t count = i + 1 < argc ? std::strtoul(argv[i + 1], nullptr, 10) : 0;
+            listBenchmarkCount = count > 0 ? count : 100000;
+        }
+    }
+    if (allocCheck && !SS::AllocationCounter::kEnabled) {
+        std::cerr << "--alloc-check needs a build with SS_COUNT_ALLOCATIONS defined (Debug)\n";
+        return 2;
+    }
+    constexpr uint64_t kAllocCheckWarmupFrames = 120;
+    constexpr uint64_t kAllocCheckFrames = 300;
+
+    // Transient containers of the main thread come from here, reset every frame
+    SS::FrameArena frameArena;
+    SS::FrameArena::setCurrent(&frameArena);
+
     // 1. Initialize sound manager
     SS::SoundManager soundManager;
-    if (soundManager.init() != 1) {
+    bool hiddenWindow = headlessThumbnails || listBenchmarkCount > 0;
+    if (!hiddenWindow && soundManager.init() != 1) {
         std::cerr << "Failed to initialize audio engine\n";
         return -1;
     }
@@ -143,6 +374,7 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (hiddenWindow) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     GLFWwindow* window = glfwCreateWindow(1280, 800, "Scene Manager Demo", nullptr, nullptr);
     if (!window) {
@@ -156,13 +388,49 @@ int main() {
         std::cerr << "Failed to initialize GLEW\n";
         return -1;
     }
+    SS::MaterialLibrary::Get().init();
 
-    glViewport(0, 0, 1280, 800);
+    SS::FramePacer framePacer;
+    framePacer.init(window);
+
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    glfwSetFramebufferSizeCallback(window, onFramebufferResize);
     glEnable(GL_DEPTH_TEST);
 
+    SS::RenderTarget sceneTarget;
+    SS::DynamicResolution dynamicResolution;
+
     // 3. Compile and link shader program
     unsigned int shaderProgram = createShaderProgram();
 
+    SS::ThumbnailCache thumbnailCache;
+    auto drawThumbnail = [&](const SS::Model& model, const glm::mat4& view, const glm::mat4& projection,
+        const glm::vec3& eye, const SS::Scene& scene) {
+        SS::MaterialLibrary::Get().bind();
+        drawModel(shaderProgram, model, SS::SkinningMode::None, glm::mat4(1.0f), view, projection, eye, scene.lightPos,
+            scene.ambientIntensity);
+    };
+
+    if (headlessThumbnails || listBenchmarkCount > 0) {
+        if (headlessThumbnails) {
+            SS::SceneManager library;
+            int written = thumbnailCache.generate(library.scenes, drawThumbnail);
+            std::cout << "Thumbnails: " << written << " written, " << library.scenes.size() - written << " up to date or skipped\n";
+        }
+        else {
+            SS::SceneManager::RunListBenchmark(listBenchmarkCount,
+                [&](const SS::Scene& scene) { return thumbnailCache.get(scene); });
+            std::cout << "Thumbnail textures resident: " << thumbnailCache.residentCount()
+                << " (limit " << SS::ThumbnailCache::kMaxTextures << ")\n";
+        }
+        thumbnailCache.release();
+        SS::MaterialLibrary::Get().shutdown();
+        glDeleteProgram(shaderProgram);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+    }
+
     // 4. Setup ImGui context and bindings
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -173,8 +441,25 @@ int main() {
 
     // 5. Create SceneManager and Model instances
     SS::SceneManager sceneManager;
-    SS::Model currentModel;
+    sceneManager.thumbnailProvider = [&](const SS::Scene& scene) { return thumbnailCache.get(scene); };
+    SS::HandlePool<SS::Model>& models = SS::ResourcePools::Get().models;
+    SS::ModelHandle currentModelHandle = models.emplace();
     std::string currentMusic;
+    SS::EditorCommandQueue editorCommands;
+    SS::OcclusionCuller occlusionCuller;
+    SS::MeshletCuller meshletCuller;
+    SS::FrameCapture frameCapture;
+    SS::GpuProfiler gpuProfiler;
+    gpuProfiler.init();
+    SS::Animator animator;
+    SS::JointPaletteBuffer jointPalette;
+    jointPalette.init();
+    SS::CrowdAnimation crowd;
+    SS::ShadowMap shadowMap;
+    shadowMap.init();
+    SS::ClusteredLighting clusteredLighting;
+    clusteredLighting.init();
+    std::vector<SS::PointLight> pointLights;
 
     // 6. Camera and lighting initial setup
     glm::vec3 camPos(-0.6f, 1.0f, 3.0f);
@@ -187,57 +472,135 @@ int main() {
     if (!sceneManager.scenes.empty()) {
         SS::Scene& first = sceneManager.scenes[0];
 
-        // Find selected indices for mesh and music
-        for (int i = 0; i < sceneManager.meshFiles.size(); ++i) {
-            if (sceneManager.meshFiles[i] == first.meshPath) {
-                sceneManager.selectedMesh = i;
-                break;
-            }
-        }
-        for (int i = 0; i < sceneManager.musicFiles.size(); ++i) {
-            if (sceneManager.musicFiles[i] == first.musicPath) {
-                sceneManager.selectedMusic = i;
-                break;
-            }
-        }
+        // Select its mesh and music once the asset lists are in
+        sceneManager.SelectAssets(first);
 
         // Load first scene model and music
-        loadScene(first, currentModel, soundManager, currentMusic);
+        loadScene(first, *models.get(currentModelHandle), soundManager, currentMusic);
         lightPos = first.lightPos;
         ambientIntensity = first.ambientIntensity;
+        pointLights = first.pointLights;
     }
 
+    // 8. Update stage: animation, crowd, light assignment and culling for one
+    // frame, written into a snapshot the render stage consumes. It reads the
+    // editor state above, which the render thread only changes while no update
+    // is in flight.
+    float updateDeltaSeconds = 0.0f;
+    SS::FramePipeline pipeline([&](SS::RenderSnapshot& frame) {
+        SS::JobSystem& jobs = SS::JobSystem::Get();
+        const SS::Model& currentModel = *models.get(currentModelHandle);
+        float aspect = framebufferHeight > 0 ? static_cast<float>(framebufferWidth) / framebufferHeight : 1.0f;
+        frame.view = glm::lookAt(camPos, camCenter, glm::vec3(0, 1, 0));
+        frame.projection = glm::perspective(glm::radians(camZoom), aspect, 0.1f, 100.0f);
+        frame.camPos = camPos;
+        frame.lightPos = lightPos;
+        frame.ambientIntensity = ambientIntensity;
+        frame.modelMatrix = glm::mat4(1.0f);
+        frame.modelRevision = currentModel.GetRevision();
+        glm::mat4 viewProj = frame.projection * frame.view;
+
+        // Advance animation; the palette goes to the skinning path on the render thread
+        animator.update(currentModel, updateDeltaSeconds);
+        frame.poseRevision = animator.poseRevision();
+
+        frame.crowdJoints = 0;
+        frame.crowdTransforms.clear();
+        frame.crowdPalettes.clear();
+        if (crowd.enabled) {
+            crowd.update(currentModel, updateDeltaSeconds, viewProj, camPos, jobs);
+            if (crowd.size() > 0 && currentModel.GetSkeleton().hasJoints()) {
+                frame.crowdJoints = crowd.jointCount();
+                for (size_t i = 0; i < crowd.size(); ++i) {
+                    if (!crowd.isVisible(i)) continue;
+                    frame.crowdTransforms.push_back(crowd.modelMatrix(i));
+                    frame.crowdPalettes.insert(frame.crowdPalettes.end(), crowd.palette(i), crowd.palette(i) + frame.crowdJoints);
+                }
+            }
+        }
+        clusteredLighting.update(pointLights, frame.view, glm::radians(camZoom), aspect, 0.1f, 100.0f, jobs);
+
+        // Cull meshes hidden behind the model's own occluder triangles. Occluders
+        // and bounds are bind pose, so animated models are not culled.
+        size_t meshCount = currentModel.GetMeshCount();
+        frame.meshVisibility.assign(meshCount, 1);
+        if (occlusionCuller.enabled && currentModel.GetAnimations().empty()) {
+            SS_PROFILE_SCOPE("Occlusion Culling");
+            occlusionCuller.beginFrame(viewProj);
+            occlusionCuller.addOccluder(currentModel.GetOccluderTriangles(), frame.modelMatrix);
+            occlusionCuller.rasterize();
+            for (size_t i = 0; i < meshCount; ++i) {
+                const SS::MeshGL& mesh = currentModel.GetMesh(i);
+                frame.meshVisibility[i] = occlusionCuller.isVisible(mesh.boundsMin, mesh.boundsMax, frame.modelMatrix);
+            }
+        }
+
+        // Meshes that survived are trimmed further per meshlet. Skinned meshes
+        // have no meshlets and are drawn whole.
+        meshletCuller.cull(currentModel, frame.modelMatrix, viewProj, camPos, jobs);
+        frame.meshlets = meshletCuller.drawList();
+    });
+
+    // Heap allocations are counted from one frame start to the next, so they
+    // include the update thread and jobs running for the frame
+    uint64_t frameNumber = 0;
+    uint64_t allocationsAtFrameStart = SS::AllocationCounter::total();
+    uint64_t lastFrameAllocations = 0;
+    uint64_t allocatingFrames = 0;
+    uint64_t worstFrameAllocations = 0;
+
     // Main loop
+    pipeline.kick();
     while (!glfwWindowShouldClose(window)) {
+        uint64_t allocationsNow = SS::AllocationCounter::total();
+        lastFrameAllocations = allocationsNow - allocationsAtFrameStart;
+        allocationsAtFrameStart = allocationsNow;
+        if (allocCheck && frameNumber > kAllocCheckWarmupFrames && lastFrameAllocations > 0) {
+            ++allocatingFrames;
+            worstFrameAllocations = std::max(worstFrameAllocations, lastFrameAllocations);
+            std::cerr << "Frame " << frameNumber << " made " << lastFrameAllocations << " heap allocation(s)\n";
+        }
+        if (allocCheck && frameNumber == kAllocCheckFrames) break;
+        ++frameNumber;
+
+        framePacer.beginFrame();
+        SS::Profiler::markFrame();
+        SS_PROFILE_SCOPE("Frame");
+        frameArena.reset();
+        // From here until kick() the update thread is idle and editor state may change
+        pipeline.waitForUpdate();
         glfwPollEvents();
+        gpuProfiler.beginFrame();
 
-        // Clear buffers
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // Scale against the GPU cost of the scene pass when it is known; the frame
+        // time alone is pinned to the refresh rate while vsync is on.
+        float sceneGpuMs = gpuProfiler.averageMs("Scene");
+        dynamicResolution.update(sceneGpuMs > 0.0f ? sceneGpuMs : framePacer.lastFrameMs());
+        clusteredLighting.sweepFrame(sceneGpuMs);
 
         // Start ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
-        // Render Scene UI, with callbacks for model, music, and scene changes
-        sceneManager.renderImGui(
-            [&](const std::string& meshPath) {
-                currentModel.LoadFromFile(meshPath);
-            },
-            [&](const std::string& musicPath) {
-                soundManager.stopMusic();
-                soundManager.playMusic(musicPath);
-                currentMusic = musicPath;
-            },
-            [&](const SS::Scene& scene) {
-                loadScene(scene, currentModel, soundManager, currentMusic);
-                lightPos = scene.lightPos;
-                ambientIntensity = scene.ambientIntensity;
-            },
-            lightPos,
-            ambientIntensity
-        );
+        // Render Scene UI; model, music, and scene changes become editor commands
+        SS::SceneEditorEvents editorEvents = sceneManager.renderImGui(lightPos, ambientIntensity, pointLights);
+        if (editorEvents.meshSelected >= 0) {
+            editorCommands.loadMesh(sceneManager.meshFiles[editorEvents.meshSelected]);
+        }
+        if (editorEvents.musicSelected >= 0) {
+            editorCommands.playMusic(sceneManager.musicFiles[editorEvents.musicSelected]);
+        }
+        if (editorEvents.sceneLoaded >= 0) {
+            editorCommands.loadScene(sceneManager.scenes[editorEvents.sceneLoaded]);
+        }
+        for (const std::string& path : editorEvents.modelsChanged) {
+            editorCommands.reloadMesh(path);
+            thumbnailCache.invalidate(path);
+        }
+        // Commands run here, the one point per frame where the scene may change
+        editorCommands.process(currentModelHandle, soundManager, currentMusic, lightPos, ambientIntensity, pointLights);
+        SS::Model& currentModel = *models.get(currentModelHandle);
 
         // Music control UI
         ImGui::Begin("Music Control");
@@ -263,31 +626,160 @@ int main() {
         ImGui::SliderFloat3("Light Position", &lightPos[0], -10.0f, 10.0f);
         ImGui::End();
 
-        // Use shader program and update uniforms
-        glUseProgram(shaderProgram);
-        glm::mat4 modelMatrix = glm::mat4(1.0f);
-        glm::mat4 viewMatrix = glm::lookAt(camPos, camCenter, glm::vec3(0, 1, 0));
-        glm::mat4 projectionMatrix = glm::perspective(glm::radians(camZoom), 1280.0f / 800.0f, 0.1f, 100.0f);
+        occlusionCuller.renderImGui();
+        framePacer.renderImGui();
+        dynamicResolution.renderImGui(framebufferWidth, framebufferHeight);
+        frameCapture.renderImGui();
+        gpuProfiler.renderImGui();
+        SS::Profiler::renderImGui();
+        SS::MemoryTracker::renderImGui();
+        animator.renderImGui(currentModel);
+        crowd.renderImGui(currentModel);
+        shadowMap.renderImGui();
+        SS::MaterialLibrary::Get().renderImGui();
+        meshletCuller.renderImGui();
+        SS::JobSystem::Get().renderImGui();
+        pipeline.renderImGui();
+        editorCommands.renderImGui();
+
+        // Frame memory UI
+        ImGui::Begin("Frame Memory");
+        ImGui::Text("Main arena: %zu / %zu KB, peak %zu KB", frameArena.bytesUsed() / 1024,
+            frameArena.capacity() / 1024, frameArena.peakBytes() / 1024);
+        const SS::FrameArena& updateArena = pipeline.updateArena();
+        ImGui::Text("Update arena: %zu / %zu KB, peak %zu KB", updateArena.bytesUsed() / 1024,
+            updateArena.capacity() / 1024, updateArena.peakBytes() / 1024);
+        if (SS::AllocationCounter::kEnabled) {
+            ImGui::Text("Heap allocations last frame: %llu", static_cast<unsigned long long>(lastFrameAllocations));
+        }
+        else {
+            ImGui::TextDisabled("Heap allocations are counted in builds with SS_COUNT_ALLOCATIONS");
+        }
+        ImGui::End();
 
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(modelMatrix));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+        glm::vec3 modelMin(0.0f), modelMax(0.0f);
+        currentModel.GetBounds(modelMin, modelMax);
+        clusteredLighting.renderImGui(pointLights, (modelMin + modelMax) * 0.5f, glm::length(modelMax - modelMin) * 0.5f);
+
+        // Hand the snapshot's results to GL, then start the next update so it runs
+        // while this frame is submitted. Unpipelined, the update runs here on this
+        // frame's input instead.
+        updateDeltaSeconds = framePacer.lastFrameMs() / 1000.0f;
+        if (!pipeline.pipelined) pipeline.kick();
+        const SS::RenderSnapshot& frame = pipeline.current();
+        // A model loaded by the UI above invalidates the snapshot's draws for one frame
+        bool sameModel = frame.modelRevision == currentModel.GetRevision();
+        // Skinning modes travel with each draw; the model itself is not changed after kick()
+        SS::SkinningMode skinning = sameModel ? animator.apply(currentModel, jointPalette) : SS::SkinningMode::None;
+        clusteredLighting.upload();
+        if (pipeline.pipelined) pipeline.kick();
+
+        // Render the scene at a scaled resolution into the offscreen target
+        bool drawScene = sceneTarget.ensureSize(framebufferWidth, framebufferHeight);
+        float renderScale = dynamicResolution.scale();
+        int renderWidth = std::max(1, static_cast<int>(framebufferWidth * renderScale));
+        int renderHeight = std::max(1, static_cast<int>(framebufferHeight * renderScale));
+
+        int frameScope = gpuProfiler.beginScope("Frame");
+        if (drawScene) {
+            SS_PROFILE_SCOPE("Render Scene");
+            const glm::mat4& modelMatrix = frame.modelMatrix;
+
+            // The shadow map is cached; camera changes alone reuse it
+            glm::vec3 boundsMin, boundsMax;
+            if (currentModel.GetBounds(boundsMin, boundsMax)) {
+                uint64_t casterRevision = (static_cast<uint64_t>(currentModel.GetRevision()) << 32) | frame.poseRevision;
+                if (shadowMap.beginUpdate(frame.lightPos, modelMatrix, casterRevision, boundsMin, boundsMax)) {
+                    SS_PROFILE_SCOPE("Shadow Map");
+                    SS::GpuTimerScope timer(gpuProfiler, "Shadow Map");
+                    GLuint depthProgram = shadowMap.depthProgram();
+                    glUniformMatrix4fv(glGetUniformLocation(depthProgram, "model"), 1, GL_FALSE, glm::value_ptr(modelMatrix));
+                    currentModel.DrawDepth(depthProgram, skinning);
+                    shadowMap.endUpdate();
+                }
+            }
+            shadowMap.applyTo(shaderProgram);
+            SS::MaterialLibrary::Get().bind();
+            clusteredLighting.applyTo(shaderProgram, renderWidth, renderHeight);
+
+            int sceneScope = gpuProfiler.beginScope("Scene");
+            sceneTarget.bind();
+            glViewport(0, 0, renderWidth, renderHeight);
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // Draw the current model
+            drawModel(shaderProgram, currentModel, skinning, modelMatrix, frame.view, frame.projection, frame.camPos,
+                frame.lightPos, frame.ambientIntensity, sameModel ? &frame.meshVisibility : nullptr,
+                sameModel ? &frame.meshlets : nullptr);
+
+            // Crowd copies through the GPU palette, one upload per visible instance
+            if (sameModel && frame.crowdJoints > 0) {
+                SS_PROFILE_SCOPE("Draw Crowd");
+                bool gpuPalette = frame.crowdJoints <= static_cast<size_t>(SS::kMaxGpuJoints);
+                SS::SkinningMode crowdSkinning = gpuPalette ? SS::SkinningMode::Gpu : SS::SkinningMode::None;
+                jointPalette.bind();
+                for (size_t i = 0; i < frame.crowdTransforms.size(); ++i) {
+                    if (gpuPalette) jointPalette.upload(&frame.crowdPalettes[i * frame.crowdJoints], frame.crowdJoints);
+                    drawModel(shaderProgram, currentModel, crowdSkinning, frame.crowdTransforms[i], frame.view, frame.projection,
+                        frame.camPos, frame.lightPos, frame.ambientIntensity);
+                }
+            }
+            gpuProfiler.endScope(sceneScope);
 
-        glUniform1f(glGetUniformLocation(shaderProgram, "ambientIntensity"), ambientIntensity);
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos"), 1, glm::value_ptr(lightPos));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(camPos));
+            // Upscale into the window framebuffer, ImGui is composited on top
+            {
+                SS::GpuTimerScope timer(gpuProfiler, "Upscale");
+                sceneTarget.blitTo(0, renderWidth, renderHeight, framebufferWidth, framebufferHeight);
+            }
 
-        // Draw the current model
-        currentModel.Draw(shaderProgram);
+            // Captures take the upscaled scene without the UI
+            {
+                SS::GpuTimerScope timer(gpuProfiler, "Capture Readback");
+                frameCapture.captureFrame(0, framebufferWidth, framebufferHeight);
+            }
+        }
+        frameCapture.poll();
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
 
         // Render ImGui
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            SS_PROFILE_SCOPE("ImGui Render");
+            SS::GpuTimerScope timer(gpuProfiler, "ImGui");
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        gpuProfiler.endScope(frameScope);
+        gpuProfiler.endFrame();
+
+        {
+            SS_PROFILE_SCOPE("Swap Buffers");
+            glfwSwapBuffers(window);
+            framePacer.endFrame();
+        }
+        pipeline.presented();
+    }
+    pipeline.waitForUpdate();
 
-        glfwSwapBuffers(window);
+    if (allocCheck) {
+        uint64_t checked = frameNumber > kAllocCheckWarmupFrames ? frameNumber - kAllocCheckWarmupFrames : 0;
+        std::cout << "Allocation check: " << allocatingFrames << " of " << checked << " steady-state frames allocated";
+        if (allocatingFrames > 0) std::cout << " (worst " << worstFrameAllocations << ")";
+        std::cout << "\n";
     }
 
     // Cleanup
+    framePacer.shutdown();
+    sceneTarget.release();
+    thumbnailCache.release();
+    frameCapture.shutdown();
+    gpuProfiler.shutdown();
+    jointPalette.shutdown();
+    shadowMap.shutdown();
+    clusteredLighting.shutdown();
+    editorCommands.shutdown();
+    models.clear();
+    SS::MaterialLibrary::Get().shutdown();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -296,6 +788,6 @@ int main() {
     glfwDestroyWindow(window);
     glfwTerminate();
 
-    return 0;
+    return allocCheck && allocatingFrames > 0 ? 1 : 0;
 }
 